@@ -56,3 +56,41 @@ zxerr_t addr_getItem(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *
             return zxerr_no_data;
     }
 }
+
+zxerr_t xpub_getNumItems(uint8_t *num_items) {
+    zemu_log_stack("xpub_getNumItems");
+    *num_items = 1;
+    if (app_mode_expert()) {
+        *num_items = 2;
+    }
+    return zxerr_ok;
+}
+
+zxerr_t xpub_getItem(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen, uint8_t pageIdx,
+                     uint8_t *pageCount) {
+    ZEMU_LOGF(50, "[xpub_getItem] %d/%d\n", displayIdx, pageIdx)
+
+    switch (displayIdx) {
+        case 0: {
+            // Every address of the account can be derived from what is exported
+            snprintf(outKey, outKeyLen, "Share account");
+            char buffer[300];
+            bip32_to_str(buffer, sizeof(buffer), hdPath, hdPath_len);
+            pageString(outVal, outValLen, buffer, pageIdx, pageCount);
+            return zxerr_ok;
+        }
+        case 1: {
+            if (!app_mode_expert()) {
+                return zxerr_no_data;
+            }
+
+            snprintf(outKey, outKeyLen, "Public key");
+            char buffer[2 * PK_LEN_SECP256K1 + 1];
+            array_to_hexstr(buffer, sizeof(buffer), G_io_apdu_buffer, PK_LEN_SECP256K1);
+            pageString(outVal, outValLen, buffer, pageIdx, pageCount);
+            return zxerr_ok;
+        }
+        default:
+            return zxerr_no_data;
+    }
+}
@@ -30,6 +30,13 @@ zxerr_t addr_getNumItems(uint8_t *num_items);
 zxerr_t addr_getItem(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outValue, uint16_t outValueLen,
                      uint8_t pageIdx, uint8_t *pageCount);
 
+// Return the number of items in the account public key view
+zxerr_t xpub_getNumItems(uint8_t *num_items);
+
+// Gets an specific item from the account public key view (including paging)
+zxerr_t xpub_getItem(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outValue, uint16_t outValueLen,
+                     uint8_t pageIdx, uint8_t *pageCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "addr_batch.h"
+
+#include "bech32_address.h"
+#include "coin.h"
+#include "zxmacros.h"
+
+#define ADDR_BATCH_HARDENED 0x80000000u
+// Path element the batch increments
+#define ADDR_BATCH_INDEX (HDPATH_LEN_DEFAULT - 1)
+
+uint16_t addr_batch_entry_len(uint8_t hrp_len) {
+    return (uint16_t)(PK_LEN_SECP256K1 + 1 + BECH32_ADDRESS_STR_LEN(hrp_len));
+}
+
+zxerr_t addr_batch_start(addr_batch_t *batch, const uint32_t *path, uint8_t count, uint8_t hrp_len) {
+    if (batch == NULL || path == NULL) {
+        return zxerr_unknown;
+    }
+    MEMZERO(batch, sizeof(*batch));
+    const uint32_t start = path[ADDR_BATCH_INDEX];
+    if (count == 0 || hrp_len == 0 || hrp_len > BECH32_ADDRESS_MAX_HRP_LEN || start >= ADDR_BATCH_HARDENED ||
+        count > ADDR_BATCH_HARDENED - start) {
+        return zxerr_out_of_bounds;
+    }
+    MEMCPY(batch->path, path, sizeof(batch->path));
+    batch->remaining = count;
+    batch->address_len = (uint8_t)BECH32_ADDRESS_STR_LEN(hrp_len);
+    return zxerr_ok;
+}
+
+zxerr_t addr_batch_pack(addr_batch_t *batch, addr_batch_fill_fn fill, uint8_t *out, uint16_t outLen,
+                        uint16_t *replyLen) {
+    if (batch == NULL || fill == NULL || out == NULL || replyLen == NULL) {
+        return zxerr_unknown;
+    }
+    *replyLen = 0;
+    if (batch->remaining == 0) {
+        return zxerr_no_data;
+    }
+
+    // Addresses of a batch share their hrp, so every entry has the same size
+    const uint16_t entry_len = (uint16_t)(PK_LEN_SECP256K1 + 1 + batch->address_len);
+    if (outLen < ADDR_BATCH_HEADER_LEN + entry_len) {
+        return zxerr_buffer_too_small;
+    }
+    const uint16_t fit = (uint16_t)((outLen - ADDR_BATCH_HEADER_LEN) / entry_len);
+    const uint8_t n_entries = (fit < batch->remaining) ? (uint8_t)fit : batch->remaining;
+
+    uint32_t path[HDPATH_LEN_DEFAULT];
+    MEMCPY(path, batch->path, sizeof(path));
+    uint8_t *entry = out + ADDR_BATCH_HEADER_LEN;
+    for (uint8_t i = 0; i < n_entries; i++) {
+        const zxerr_t err = fill(path, HDPATH_LEN_DEFAULT, entry, (char *)(entry + PK_LEN_SECP256K1 + 1),
+                                 batch->address_len);
+        if (err != zxerr_ok) {
+            MEMZERO(out, outLen);
+            return err;
+        }
+        entry[PK_LEN_SECP256K1] = batch->address_len;
+        entry += entry_len;
+        path[ADDR_BATCH_INDEX]++;
+    }
+
+    MEMCPY(batch->path, path, sizeof(batch->path));
+    batch->remaining -= n_entries;
+    out[0] = n_entries;
+    out[1] = batch->remaining;
+    *replyLen = (uint16_t)(ADDR_BATCH_HEADER_LEN + n_entries * entry_len);
+    return zxerr_ok;
+}
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "coin.h"
+#include "zxerror.h"
+
+// Reply of INS_GET_ADDR_BATCH: entries in this reply (1) and addresses left after it (1),
+// then per entry the compressed pubkey (33), the address length (1) and the address
+#define ADDR_BATCH_HEADER_LEN 2u
+
+// Addresses one request can export
+#define ADDR_BATCH_MAX_COUNT 255u
+
+// The batch keeps its own path, so other instructions keep theirs between its replies
+typedef struct {
+    uint32_t path[HDPATH_LEN_DEFAULT];  // path of the next entry
+    uint8_t remaining;                  // entries not replied yet
+    uint8_t address_len;
+} addr_batch_t;
+
+// Writes the compressed pubkey and the address_len characters of the address at path
+typedef zxerr_t (*addr_batch_fill_fn)(const uint32_t *path, uint32_t path_len, uint8_t *pubkey, char *address,
+                                      uint16_t addressLen);
+
+// Bytes taken by one entry for addresses with an hrp of hrp_len characters
+uint16_t addr_batch_entry_len(uint8_t hrp_len);
+
+// Exports count addresses from path on, incrementing its last index, which must stay non-hardened
+zxerr_t addr_batch_start(addr_batch_t *batch, const uint32_t *path, uint8_t count, uint8_t hrp_len);
+
+// Packs as many of the remaining entries as fit in out, and moves the batch past them
+zxerr_t addr_batch_pack(addr_batch_t *batch, addr_batch_fill_fn fill, uint8_t *out, uint16_t outLen,
+                        uint16_t *replyLen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,9 +22,11 @@
 
 #include "actions.h"
 #include "addr.h"
+#include "addr_batch.h"
 #include "apdu_handler_evm.h"
 #include "app_main.h"
 #include "app_mode.h"
+#include "bech32_address.h"
 #include "coin.h"
 #include "coin_evm.h"
 #include "crypto.h"
@@ -42,19 +44,50 @@ static bool tx_initialized = false;
 // Storage for the review-pending lock declared in actions.h.
 volatile bool g_review_pending = false;
 
-void extractHDPath(uint32_t rx, uint32_t offset) {
+// Reads path_len path elements at offset into hdPath, rejecting paths of other coins
+static void extractPath(uint32_t rx, uint32_t offset, uint32_t path_len) {
     tx_initialized = false;
 
-    if (rx < offset || (rx - offset) < sizeof(uint32_t) * HDPATH_LEN_DEFAULT) {
+    if (rx < offset || (rx - offset) < sizeof(uint32_t) * path_len) {
         THROW(APDU_CODE_WRONG_LENGTH);
     }
 
-    memcpy(hdPath, G_io_apdu_buffer + offset, sizeof(uint32_t) * HDPATH_LEN_DEFAULT);
+    uint32_t path[HDPATH_LEN_DEFAULT];
+    memcpy(path, G_io_apdu_buffer + offset, sizeof(uint32_t) * path_len);
 
-    if (hdPath[0] != HDPATH_ETH_0_DEFAULT || (hdPath[1] != HDPATH_ETH_1_DEFAULT)) {
+    if (path[0] != HDPATH_ETH_0_DEFAULT || (path[1] != HDPATH_ETH_1_DEFAULT)) {
         THROW(APDU_CODE_DATA_INVALID);
     }
-    hdPath_len = HDPATH_LEN_DEFAULT;
+
+    // Keys derived for the previous path no longer apply
+    if (hdPath_len != path_len || memcmp(hdPath, path, sizeof(uint32_t) * path_len) != 0) {
+        crypto_key_cache_invalidate();
+    }
+    memcpy(hdPath, path, sizeof(uint32_t) * path_len);
+    hdPath_len = path_len;
+}
+
+void extractHDPath(uint32_t rx, uint32_t offset) { extractPath(rx, offset, HDPATH_LEN_DEFAULT); }
+
+// Account nodes are hardened, so their public key can't be derived from the coin's
+static void extractAccountPath(uint32_t rx, uint32_t offset) {
+    extractPath(rx, offset, HDPATH_LEN_ACCOUNT);
+    if ((hdPath[HDPATH_LEN_ACCOUNT - 1] & 0x80000000u) == 0) {
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+}
+
+static void extractSignatureFormat(void) {
+    switch (G_io_apdu_buffer[OFFSET_P2]) {
+        case signature_rsv:
+            signature_format = signature_rsv;
+            break;
+        case signature_rsv_der:
+            signature_format = signature_rsv_der;
+            break;
+        default:
+            THROW(APDU_CODE_INVALIDP1P2);
+    }
 }
 
 uint8_t extractHRP(uint32_t rx, uint32_t offset) {
@@ -79,7 +112,9 @@ uint8_t extractHRP(uint32_t rx, uint32_t offset) {
     return bech32_hrp_len;
 }
 
-__Z_INLINE bool process_chunk(__Z_UNUSED volatile uint32_t *tx, uint32_t rx) {
+// When parse_chunks is set, every P1_ADD chunk is run through the resumable
+// parser so a malformed transaction is rejected as soon as it is received.
+__Z_INLINE bool process_chunk(volatile uint32_t *tx, uint32_t rx, bool parse_chunks) {
     const uint8_t payloadType = G_io_apdu_buffer[OFFSET_PAYLOAD_TYPE];
     if (rx < OFFSET_DATA) {
         THROW(APDU_CODE_WRONG_LENGTH);
@@ -91,6 +126,7 @@ __Z_INLINE bool process_chunk(__Z_UNUSED volatile uint32_t *tx, uint32_t rx) {
             tx_initialize();
             tx_reset();
             extractHDPath(rx, OFFSET_DATA);
+            extractSignatureFormat();
             tx_initialized = true;
             return false;
         case P1_ADD:
@@ -102,6 +138,17 @@ __Z_INLINE bool process_chunk(__Z_UNUSED volatile uint32_t *tx, uint32_t rx) {
                 tx_initialized = false;
                 THROW(APDU_CODE_OUTPUT_BUFFER_TOO_SMALL);
             }
+            if (parse_chunks) {
+                const char *error_msg = tx_parse_chunk();
+                CHECK_APP_CANARY()
+                if (error_msg != NULL) {
+                    tx_initialized = false;
+                    const int error_msg_length = strnlen(error_msg, sizeof(G_io_apdu_buffer));
+                    memcpy(G_io_apdu_buffer, error_msg, error_msg_length);
+                    *tx += (error_msg_length);
+                    THROW(APDU_CODE_DATA_INVALID);
+                }
+            }
             return false;
         case P1_LAST:
             if (!tx_initialized) {
@@ -145,9 +192,99 @@ __Z_INLINE void handleGetAddr(volatile uint32_t *flags, volatile uint32_t *tx, u
     THROW(APDU_CODE_OK);
 }
 
+// Batch being exported, with the hrp it was started with so other
+// instructions can run between its replies. The batch keeps its own path,
+// hdPath stays the one of the last address or signing request.
+static addr_batch_t addr_batch;
+static char addr_batch_hrp[MAX_BECH32_HRP_LEN + 1];
+static uint8_t addr_batch_hrp_len;
+
+static zxerr_t addr_batch_fill(const uint32_t *path, uint32_t path_len, uint8_t *pubkey, char *address,
+                               uint16_t addressLen) {
+    uint8_t buffer[PK_LEN_SECP256K1 + BECH32_ADDRESS_STR_LEN(BECH32_ADDRESS_MAX_HRP_LEN) + 1];
+    uint16_t len = 0;
+
+    CHECK_ZXERR(crypto_fillAddressOfPath(path, path_len, buffer, sizeof(buffer), &len))
+    if (len != PK_LEN_SECP256K1 + addressLen) {
+        return zxerr_encoding_failed;
+    }
+    MEMCPY(pubkey, buffer, PK_LEN_SECP256K1);
+    MEMCPY(address, buffer + PK_LEN_SECP256K1, addressLen);
+    return zxerr_ok;
+}
+
+__Z_INLINE void handleGetAddrBatch(__Z_UNUSED volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    zemu_log("handleGetAddrBatch\n");
+
+    switch (G_io_apdu_buffer[OFFSET_P1]) {
+        case P1_BATCH_START: {
+            // hrp, path of the first address, count
+            const uint8_t len = extractHRP(rx, OFFSET_DATA);
+            const uint32_t path_offset = OFFSET_DATA + 1 + len;
+            extractHDPath(rx, path_offset);
+            const uint32_t count_offset = path_offset + sizeof(uint32_t) * HDPATH_LEN_DEFAULT;
+            if (rx < count_offset + 1) {
+                THROW(APDU_CODE_WRONG_LENGTH);
+            }
+            if (addr_batch_start(&addr_batch, hdPath, G_io_apdu_buffer[count_offset], len) != zxerr_ok) {
+                THROW(APDU_CODE_DATA_INVALID);
+            }
+            MEMCPY(addr_batch_hrp, bech32_hrp, sizeof(addr_batch_hrp));
+            addr_batch_hrp_len = len;
+            break;
+        }
+        case P1_BATCH_NEXT:
+            if (addr_batch.remaining == 0) {
+                THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
+            }
+            MEMCPY(bech32_hrp, addr_batch_hrp, sizeof(addr_batch_hrp));
+            bech32_hrp_len = addr_batch_hrp_len;
+            break;
+        default:
+            THROW(APDU_CODE_INVALIDP1P2);
+    }
+
+    // Put data directly in the apdu buffer, leaving room for the status word
+    MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
+    uint16_t replyLen = 0;
+    const zxerr_t zxerr = addr_batch_pack(&addr_batch, addr_batch_fill, G_io_apdu_buffer, IO_APDU_BUFFER_SIZE - 2,
+                                          &replyLen);
+    if (zxerr != zxerr_ok) {
+        MEMZERO(&addr_batch, sizeof(addr_batch));
+        *tx = 0;
+        THROW(APDU_CODE_EXECUTION_ERROR);
+    }
+
+    *tx = replyLen;
+    THROW(APDU_CODE_OK);
+}
+
+__Z_INLINE void handleGetXpub(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    zemu_log("handleGetXpub\n");
+    extractAccountPath(rx, OFFSET_DATA);
+
+    const uint8_t requireConfirmation = G_io_apdu_buffer[OFFSET_P1];
+
+    const zxerr_t zxerr = app_fill_xpub();
+    if (zxerr != zxerr_ok) {
+        *tx = 0;
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+
+    if (requireConfirmation) {
+        view_review_init(xpub_getItem, xpub_getNumItems, app_reply_address);
+        view_review_show(REVIEW_ADDRESS);
+        *flags |= IO_ASYNCH_REPLY;
+        return;
+    }
+
+    *tx = action_addrResponseLen;
+    THROW(APDU_CODE_OK);
+}
+
 __Z_INLINE void handleSign(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
     zemu_log("handleSign\n");
-    if (!process_chunk(tx, rx)) {
+    if (!process_chunk(tx, rx, true)) {
         THROW(APDU_CODE_OK);
     }
 
@@ -175,7 +312,7 @@ __Z_INLINE void handleSign(volatile uint32_t *flags, volatile uint32_t *tx, uint
 
 __Z_INLINE void handleSignHash(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
     zemu_log("handleSignHash\n");
-    if (!process_chunk(tx, rx)) {
+    if (!process_chunk(tx, rx, false)) {
         THROW(APDU_CODE_OK);
     }
 
@@ -273,11 +410,30 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                         break;
                     }
 
+                    case INS_GET_ADDR_BATCH: {
+                        if (cla != CLA) {
+                            THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
+                        }
+                        CHECK_PIN_VALIDATED()
+                        handleGetAddrBatch(flags, tx, rx);
+                        break;
+                    }
+
+                    case INS_GET_XPUB: {
+                        if (cla != CLA) {
+                            THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
+                        }
+                        CHECK_PIN_VALIDATED()
+                        handleGetXpub(flags, tx, rx);
+                        break;
+                    }
+
                     case INS_SIGN: {
                         if (cla != CLA) {
                             THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
                         }
                         CHECK_PIN_VALIDATED()
+                        tx_select_digest(crypto_digest_sha256);
                         handleSign(flags, tx, rx);
                         break;
                     }
@@ -287,6 +443,7 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                             THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
                         }
                         CHECK_PIN_VALIDATED()
+                        tx_select_digest(crypto_digest_none);
                         handleSignHash(flags, tx, rx);
                         break;
                     }
@@ -295,6 +452,7 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                         if (cla != CLA_ETH) {
                             THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
                         }
+                        tx_select_digest(crypto_digest_keccak256);
                         handleSignEth(flags, tx, rx);
                         break;
                     }
@@ -303,6 +461,7 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                         if (cla != CLA_ETH) {
                             THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
                         }
+                        tx_select_digest(crypto_digest_none);
                         handleSignEip191(flags, tx, rx);
                         break;
                     }
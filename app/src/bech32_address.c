@@ -0,0 +1,103 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "bech32_address.h"
+
+#include "zxmacros.h"
+
+static const char bech32_charset[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+// Generator terms for each value of the 5 bits shifted out of the checksum
+static const uint32_t bech32_generator_table[32] = {
+    0x00000000, 0x3b6a57b2, 0x26508e6d, 0x1d3ad9df, 0x1ea119fa, 0x25cb4e48, 0x38f19797, 0x039bc025,
+    0x3d4233dd, 0x0628646f, 0x1b12bdb0, 0x2078ea02, 0x23e32a27, 0x18897d95, 0x05b3a44a, 0x3ed9f3f8,
+    0x2a1462b3, 0x117e3501, 0x0c44ecde, 0x372ebb6c, 0x34b57b49, 0x0fdf2cfb, 0x12e5f524, 0x298fa296,
+    0x1756516e, 0x2c3c06dc, 0x3106df03, 0x0a6c88b1, 0x09f74894, 0x329d1f26, 0x2fa7c6f9, 0x14cd914b,
+};
+
+static inline uint32_t bech32_polymod_step(const uint32_t *table, uint32_t chk, uint8_t value) {
+    return ((chk & 0x1FFFFFFU) << 5) ^ table[chk >> 25] ^ value;
+}
+
+zxerr_t bech32_hrp_state(const char *hrp, uint8_t hrpLen, uint32_t *state) {
+    if (hrp == NULL || state == NULL || hrpLen == 0 || hrpLen > BECH32_ADDRESS_MAX_HRP_LEN) {
+        return zxerr_encoding_failed;
+    }
+
+    const uint32_t *table = (const uint32_t *)PIC(bech32_generator_table);
+    uint32_t chk = 1;
+    for (uint8_t i = 0; i < hrpLen; i++) {
+        const uint8_t c = (uint8_t)hrp[i];
+        if (c < 33 || c > 126 || (c >= 'A' && c <= 'Z')) {
+            return zxerr_encoding_failed;
+        }
+        chk = bech32_polymod_step(table, chk, c >> 5);
+    }
+    chk = bech32_polymod_step(table, chk, 0);
+    for (uint8_t i = 0; i < hrpLen; i++) {
+        chk = bech32_polymod_step(table, chk, (uint8_t)hrp[i] & 0x1F);
+    }
+
+    *state = chk;
+    return zxerr_ok;
+}
+
+zxerr_t bech32_encode_address(char *out, uint16_t outLen, const char *hrp, uint8_t hrpLen, uint32_t hrpState,
+                              const uint8_t *address) {
+    if (out == NULL || hrp == NULL || address == NULL || hrpLen > BECH32_ADDRESS_MAX_HRP_LEN) {
+        return zxerr_encoding_failed;
+    }
+    if (outLen < BECH32_ADDRESS_STR_LEN(hrpLen) + 1) {
+        return zxerr_buffer_too_small;
+    }
+
+    const uint32_t *table = (const uint32_t *)PIC(bech32_generator_table);
+    const char *charset = (const char *)PIC(bech32_charset);
+
+    MEMCPY(out, hrp, hrpLen);
+    char *p = out + hrpLen;
+    *p++ = '1';
+
+    // Every 5 bytes are exactly 8 symbols, so ADDRESS_LEN needs no padding
+    uint32_t chk = hrpState;
+    for (uint8_t i = 0; i < ADDRESS_LEN; i += 5) {
+        const uint8_t *b = address + i;
+        const uint8_t symbols[8] = {
+            (uint8_t)(b[0] >> 3),
+            (uint8_t)(((b[0] & 0x07) << 2) | (b[1] >> 6)),
+            (uint8_t)((b[1] >> 1) & 0x1F),
+            (uint8_t)(((b[1] & 0x01) << 4) | (b[2] >> 4)),
+            (uint8_t)(((b[2] & 0x0F) << 1) | (b[3] >> 7)),
+            (uint8_t)((b[3] >> 2) & 0x1F),
+            (uint8_t)(((b[3] & 0x03) << 3) | (b[4] >> 5)),
+            (uint8_t)(b[4] & 0x1F),
+        };
+        for (uint8_t j = 0; j < sizeof(symbols); j++) {
+            chk = bech32_polymod_step(table, chk, symbols[j]);
+            *p++ = charset[symbols[j]];
+        }
+    }
+
+    for (uint8_t i = 0; i < BECH32_ADDRESS_CHECKSUM_CHARS; i++) {
+        chk = bech32_polymod_step(table, chk, 0);
+    }
+    chk ^= 1;
+    for (uint8_t i = 0; i < BECH32_ADDRESS_CHECKSUM_CHARS; i++) {
+        *p++ = charset[(chk >> (5 * (BECH32_ADDRESS_CHECKSUM_CHARS - 1 - i))) & 0x1F];
+    }
+    *p = '\0';
+
+    return zxerr_ok;
+}
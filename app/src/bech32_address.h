@@ -0,0 +1,48 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+
+#include "parser_txdef.h"
+#include "zxerror.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bech32 for ADDRESS_LEN payloads. The checksum state after the HRP depends only on the HRP, so it
+// is computed once (networks keep theirs precomputed) and every address only runs its 32 data
+// symbols and the 6 checksum rounds.
+#define BECH32_ADDRESS_DATA_CHARS 32
+#define BECH32_ADDRESS_CHECKSUM_CHARS 6
+
+// hrp + separator + data + checksum, without the terminator
+#define BECH32_ADDRESS_STR_LEN(HRP_LEN) ((HRP_LEN) + 1 + BECH32_ADDRESS_DATA_CHARS + BECH32_ADDRESS_CHECKSUM_CHARS)
+
+// Longest HRP a bech32 string of an address can carry (90 characters in total)
+#define BECH32_ADDRESS_MAX_HRP_LEN 51
+
+// Checksum state after the expanded hrp, rejects HRPs bech32EncodeFromBytes would reject
+zxerr_t bech32_hrp_state(const char *hrp, uint8_t hrpLen, uint32_t *state);
+
+// Same output as bech32EncodeFromBytes(out, outLen, hrp, address, ADDRESS_LEN, 1, BECH32_ENCODING_BECH32)
+zxerr_t bech32_encode_address(char *out, uint16_t outLen, const char *hrp, uint8_t hrpLen, uint32_t hrpState,
+                              const uint8_t *address);
+
+#ifdef __cplusplus
+}
+#endif
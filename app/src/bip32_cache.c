@@ -0,0 +1,107 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "bip32_cache.h"
+
+#include <stdbool.h>
+
+#include "coin.h"
+#include "zxmacros.h"
+
+// Last parent node reached from the seed. Deriving from the seed costs an HMAC per level and
+// a point multiplication per non-hardened level; a child of the cached node costs one HMAC
+// and a scalar addition.
+typedef struct {
+    bool valid;
+    uint32_t path[MAX_BIP32_PATH];
+    uint32_t path_len;
+    uint8_t private_key[BIP32_KEY_LEN];
+    uint8_t chain_code[BIP32_CHAIN_CODE_LEN];
+    uint8_t public_key[BIP32_PUBKEY_LEN];
+} bip32_node_t;
+
+static bip32_node_t parent;
+
+void bip32_cache_wipe(void) { MEMZERO(&parent, sizeof(parent)); }
+
+static bool parent_matches(const uint32_t *path, uint32_t path_len) {
+    return parent.valid && parent.path_len == path_len && MEMCMP(parent.path, path, sizeof(uint32_t) * path_len) == 0;
+}
+
+static zxerr_t parent_load(const uint32_t *path, uint32_t path_len) {
+    CHECK_ZXERR(bip32_derive_node(path, path_len, parent.private_key, parent.chain_code))
+    CHECK_ZXERR(bip32_public_key(parent.private_key, parent.public_key))
+    MEMCPY(parent.path, path, sizeof(uint32_t) * path_len);
+    parent.path_len = path_len;
+    parent.valid = true;
+    return zxerr_ok;
+}
+
+// CKDpriv for a non-hardened index: I = HMAC-SHA512(c, serP(K) || ser32(i)), k = IL + k_par
+static zxerr_t child_derive(uint32_t index, uint8_t *private_key, uint8_t *chain_code) {
+    uint8_t data[BIP32_PUBKEY_LEN + sizeof(uint32_t)];
+    uint8_t mac[BIP32_KEY_LEN + BIP32_CHAIN_CODE_LEN];
+
+    MEMCPY(data, parent.public_key, BIP32_PUBKEY_LEN);
+    data[BIP32_PUBKEY_LEN] = (uint8_t)(index >> 24);
+    data[BIP32_PUBKEY_LEN + 1] = (uint8_t)(index >> 16);
+    data[BIP32_PUBKEY_LEN + 2] = (uint8_t)(index >> 8);
+    data[BIP32_PUBKEY_LEN + 3] = (uint8_t)index;
+
+    zxerr_t err = bip32_hmac_sha512(parent.chain_code, data, sizeof(data), mac);
+    if (err == zxerr_ok) {
+        MEMCPY(private_key, parent.private_key, BIP32_KEY_LEN);
+        err = bip32_scalar_add(mac, private_key);
+    }
+    if (err == zxerr_ok && chain_code != NULL) {
+        MEMCPY(chain_code, mac + BIP32_KEY_LEN, BIP32_CHAIN_CODE_LEN);
+    }
+    MEMZERO(mac, sizeof(mac));
+    return err;
+}
+
+zxerr_t bip32_cache_derive(const uint32_t *path, uint32_t path_len, uint8_t *private_key, uint8_t *chain_code) {
+    if (path == NULL || private_key == NULL || path_len == 0 || path_len > MAX_BIP32_PATH) {
+        return zxerr_invalid_crypto_settings;
+    }
+    const uint32_t parent_len = path_len - 1;
+    const uint32_t index = path[parent_len];
+
+    if (!parent_matches(path, parent_len)) {
+        bip32_cache_wipe();
+    }
+
+    zxerr_t err = zxerr_ok;
+    if ((index & BIP32_HARDENED) != 0 || parent_len == 0) {
+        // Hardened children need the parent private key in the HMAC, take them from the seed
+        err = bip32_derive_node(path, path_len, private_key, chain_code);
+    } else {
+        if (!parent.valid) {
+            err = parent_load(path, parent_len);
+        }
+        if (err == zxerr_ok) {
+            err = child_derive(index, private_key, chain_code);
+        }
+    }
+
+    if (err != zxerr_ok) {
+        bip32_cache_wipe();
+        MEMZERO(private_key, BIP32_KEY_LEN);
+        if (chain_code != NULL) {
+            MEMZERO(chain_code, BIP32_CHAIN_CODE_LEN);
+        }
+    }
+    return err;
+}
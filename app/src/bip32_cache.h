@@ -0,0 +1,50 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "zxerror.h"
+
+#define BIP32_KEY_LEN 32u
+#define BIP32_CHAIN_CODE_LEN 32u
+#define BIP32_PUBKEY_LEN 33u
+#define BIP32_HARDENED 0x80000000u
+
+// Private key, and chain code when not NULL, of path. A path ending in a non-hardened
+// index goes through the cached parent node, which is rebuilt from the seed when the
+// parent path changes. Any error wipes the cache.
+zxerr_t bip32_cache_derive(const uint32_t *path, uint32_t path_len, uint8_t *private_key, uint8_t *chain_code);
+
+// Drops the cached parent node
+void bip32_cache_wipe(void);
+
+// Primitives the cache is built on, provided by crypto.c on device
+// Node of path derived from the seed
+zxerr_t bip32_derive_node(const uint32_t *path, uint32_t path_len, uint8_t *private_key, uint8_t *chain_code);
+// Compressed public key of private_key
+zxerr_t bip32_public_key(const uint8_t *private_key, uint8_t *public_key);
+zxerr_t bip32_hmac_sha512(const uint8_t *key, const uint8_t *data, uint16_t dataLen, uint8_t *mac);
+// private_key = (tweak + private_key) mod n, failing when tweak >= n or the result is 0
+zxerr_t bip32_scalar_add(const uint8_t *tweak, uint8_t *private_key);
+
+#ifdef __cplusplus
+}
+#endif
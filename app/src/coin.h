@@ -27,6 +27,22 @@ typedef enum {
 } address_encoding_e;
 
 #define INS_SIGN_HASH 0x3
+
+// Addresses from a start index in one or more replies: P1 starts the batch or asks for its next reply
+#define INS_GET_ADDR_BATCH 0x5
+#define P1_BATCH_START 0x00
+#define P1_BATCH_NEXT 0x01
+
+// Compressed pubkey and chain code of an account node, m/44'/coin'/account'
+#define INS_GET_XPUB 0x6
+#define HDPATH_LEN_ACCOUNT 3
+#define CHAIN_CODE_LEN 32u
+
+// Signature reply of INS_SIGN and INS_SIGN_HASH, selected by P2 of the init chunk
+typedef enum {
+    signature_rsv = 0,
+    signature_rsv_der = 1,
+} signature_format_e;
 #define MAX_BIP32_PATH 10
 #define HDPATH_LEN_DEFAULT 5
 
@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include "apdu_codes.h"
+#include "bip32_cache.h"
 #include "coin.h"
 #include "crypto.h"
 #include "crypto_evm.h"
@@ -55,6 +56,22 @@ __Z_INLINE zxerr_t app_fill_address() {
     return zxerr_ok;
 }
 
+__Z_INLINE zxerr_t app_fill_xpub() {
+    zemu_log("app_fill_xpub\n");
+
+    // Put data directly in the apdu buffer
+    MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
+
+    action_addrResponseLen = 0;
+    const zxerr_t err = crypto_fillXpub(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE, &action_addrResponseLen);
+
+    if (err != zxerr_ok || action_addrResponseLen == 0) {
+        THROW(APDU_CODE_EXECUTION_ERROR);
+    }
+
+    return zxerr_ok;
+}
+
 __Z_INLINE zxerr_t app_fill_eth_address() {
     // Put data directly in the apdu buffer
     MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
@@ -103,12 +120,14 @@ __Z_INLINE void app_sign_hash() {
 
 __Z_INLINE void app_sign_eth() {
     review_clear_pending();
-    const uint8_t *message = tx_get_buffer();
-    const uint16_t messageLength = tx_get_buffer_length();
     uint16_t replyLen = 0;
-
+    uint8_t hash[32] = {0};
     MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
-    zxerr_t err = crypto_sign_eth(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE - 3, message, messageLength, &replyLen, false);
+    // Keccak-256 of the tx, kept while its chunks were appended
+    zxerr_t err = tx_get_keccak_digest(hash, sizeof(hash));
+    if (err == zxerr_ok) {
+        err = crypto_sign_eth(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE - 3, hash, sizeof(hash), &replyLen, true);
+    }
 
     if (err != zxerr_ok || replyLen == 0) {
         set_code(G_io_apdu_buffer, 0, APDU_CODE_SIGN_VERIFY_ERROR);
@@ -141,6 +160,8 @@ __Z_INLINE void app_sign_evm_eip191() {
 
 __Z_INLINE void app_reject() {
     review_clear_pending();
+    // Drop the cached parent key, the host has to start over after a reject
+    bip32_cache_wipe();
     MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
     set_code(G_io_apdu_buffer, 0, APDU_CODE_COMMAND_NOT_ALLOWED);
     io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
@@ -17,8 +17,18 @@
 #include <os_io_seproxyhal.h>
 
 #include "app_main.h"
+#include "bip32_cache.h"
 #include "view.h"
 
+void __real_os_sched_exit(bolos_task_status_t exit_code);
+
+// The app is linked with --wrap=os_sched_exit, so every exit through os_sched_exit, including
+// quitting from zxlib's menu, wipes the cached parent key before the app hands control back to the OS.
+void __wrap_os_sched_exit(bolos_task_status_t exit_code) {
+    bip32_cache_wipe();
+    __real_os_sched_exit(exit_code);
+}
+
 __attribute__((section(".boot"))) int main(void) {
     // exit critical section
     __asm volatile("cpsie i");
@@ -32,7 +42,11 @@ __attribute__((section(".boot"))) int main(void) {
             app_main();
         }
         CATCH_OTHER(e) { UNUSED(e); }
-        FINALLY {}
+        FINALLY {
+            // Only reached when app_main unwinds with an exception; other exits go through
+            // __wrap_os_sched_exit
+            bip32_cache_wipe();
+        }
     }
     END_TRY;
 }
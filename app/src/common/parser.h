@@ -29,6 +29,18 @@ parser_error_t parser_init_context(parser_context_t *ctx, const uint8_t *buffer,
 //// parses a tx buffer
 parser_error_t parser_parse(parser_context_t *ctx, const uint8_t *data, size_t dataLen, parser_tx_t *tx_obj);
 
+//// parses the part of a tx buffer received so far, resuming where the previous call stopped
+//// tx_obj must be zeroed before the first chunk; set last once the whole tx is in data
+parser_error_t parser_parse_chunk(parser_context_t *ctx, const uint8_t *data, size_t dataLen, parser_tx_t *tx_obj,
+                                  bool last);
+
+//// sets the address the signing key receives change on; outputs of a send paying only to it
+//// are left out of the review outside expert mode. NULL shows every output.
+parser_error_t parser_set_change_address(const uint8_t *address, uint16_t addressLen);
+
+//// provides the digest of the parsed tx so it is not hashed again for display
+parser_error_t parser_set_tx_hash(parser_context_t *ctx, const uint8_t *hash, uint16_t hashLen);
+
 //// verifies tx fields
 parser_error_t parser_validate(parser_context_t *ctx);
 
@@ -39,6 +51,11 @@ parser_error_t parser_getNumItems(const parser_context_t *ctx, uint8_t *num_item
 parser_error_t parser_getItem(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
                               char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
 
+// number of pages parser_getItem splits displayIdx into for a value buffer of outValLen,
+// rendering the value only when its length is not known from its type
+parser_error_t parser_getItemPageCount(const parser_context_t *ctx, uint8_t displayIdx, uint16_t outValLen,
+                                       uint8_t *pageCount);
+
 parser_error_t cleanOutput(char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen);
 
 parser_error_t checkSanity(uint8_t numItems, uint8_t displayIdx);
@@ -81,6 +81,15 @@ typedef struct {
     parser_tx_t *tx_obj;
 } parser_context_t;
 
+// Resolves a field of the parsed tx, stored as an offset into ctx->buffer.
+// Returns NULL for a field that was never parsed.
+static inline const uint8_t *parser_tx_field(const parser_context_t *ctx, uint16_t offset) {
+    if (offset == PARSER_TX_NO_OFFSET) {
+        return NULL;
+    }
+    return ctx->buffer + offset;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,8 @@
 
 #include "apdu_codes.h"
 #include "buffering.h"
+#include "crypto.h"
+#include "crypto_helper.h"
 #include "parser.h"
 #include "zxmacros.h"
 
@@ -40,22 +42,127 @@ storage_t NV_CONST N_appdata_impl __attribute__((aligned(64)));
 static parser_tx_t tx_obj;
 static parser_context_t ctx_parsed_tx;
 
+// Buffer the chunked parse is running on. Spilling from RAM to flash moves
+// the data, so the parse has to start over on the new buffer.
+static const uint8_t *tx_parsed_buffer = NULL;
+
+// Digest of the buffered transaction, updated on every append so it is
+// ready as soon as the last chunk arrives. Only the digest the current
+// instruction consumes is computed.
+typedef enum {
+    tx_digest_running = 0,
+    tx_digest_ready,
+    tx_digest_invalid,
+} tx_digest_state_e;
+
+static crypto_digest_t tx_digest_ctx;
+static crypto_digest_kind_e tx_digest_kind = crypto_digest_sha256;
+static tx_digest_state_e tx_digest_state = tx_digest_invalid;
+static uint8_t tx_digest[TX_HASH_LEN];
+
+static void tx_digest_reset() {
+    MEMZERO(tx_digest, sizeof(tx_digest));
+    tx_digest_state =
+        crypto_digest_init(&tx_digest_ctx, tx_digest_kind) == zxerr_ok ? tx_digest_running : tx_digest_invalid;
+}
+
+static zxerr_t tx_digest_finalize() {
+    if (tx_digest_state == tx_digest_ready) {
+        return zxerr_ok;
+    }
+    if (tx_digest_state != tx_digest_running) {
+        return zxerr_unknown;
+    }
+
+    const zxerr_t err = crypto_digest_final(&tx_digest_ctx, tx_digest, sizeof(tx_digest));
+    MEMZERO(&tx_digest_ctx, sizeof(tx_digest_ctx));
+    tx_digest_state = err == zxerr_ok ? tx_digest_ready : tx_digest_invalid;
+    return err;
+}
+
+static zxerr_t tx_get_digest(crypto_digest_kind_e kind, uint8_t *digest, uint16_t digestLen) {
+    if (digest == NULL || digestLen < sizeof(tx_digest)) {
+        return zxerr_buffer_too_small;
+    }
+    if (tx_digest_kind != kind) {
+        return zxerr_no_data;
+    }
+    CHECK_ZXERR(tx_digest_finalize())
+    MEMCPY(digest, tx_digest, sizeof(tx_digest));
+    return zxerr_ok;
+}
+
+void tx_select_digest(crypto_digest_kind_e kind) {
+    if (kind == tx_digest_kind) {
+        return;
+    }
+    // Chunks already appended were hashed with the previous kind
+    tx_digest_kind = kind;
+    MEMZERO(&tx_digest_ctx, sizeof(tx_digest_ctx));
+    tx_digest_state = tx_digest_invalid;
+}
+
 void tx_initialize() {
     buffering_init(ram_buffer, sizeof(ram_buffer), (uint8_t *)N_appdata.buffer, sizeof(N_appdata.buffer));
+    tx_digest_reset();
 }
 
-void tx_reset() { buffering_reset(); }
+void tx_reset() {
+    buffering_reset();
+    tx_digest_reset();
+    MEMZERO(&tx_obj, sizeof(tx_obj));
+    tx_parsed_buffer = NULL;
+    parser_set_change_address(NULL, 0);
+}
+
+uint32_t tx_append(unsigned char *buffer, uint32_t length) {
+    const uint32_t added = buffering_append(buffer, length);
+
+    // Data appended after the digests were finalized is not covered by them
+    if (tx_digest_state != tx_digest_running ||
+        crypto_digest_update(&tx_digest_ctx, buffer, (uint16_t)added) != zxerr_ok) {
+        tx_digest_state = tx_digest_invalid;
+    }
 
-uint32_t tx_append(unsigned char *buffer, uint32_t length) { return buffering_append(buffer, length); }
+    return added;
+}
 
 uint32_t tx_get_buffer_length() { return buffering_get_buffer()->pos; }
 
 uint8_t *tx_get_buffer() { return buffering_get_buffer()->data; }
 
-const char *tx_parse(uint8_t *error_code) {
-    MEMZERO(&tx_obj, sizeof(tx_obj));
+zxerr_t tx_get_sha256_digest(uint8_t *digest, uint16_t digestLen) {
+    return tx_get_digest(crypto_digest_sha256, digest, digestLen);
+}
+
+zxerr_t tx_get_keccak_digest(uint8_t *digest, uint16_t digestLen) {
+    return tx_get_digest(crypto_digest_keccak256, digest, digestLen);
+}
+
+static parser_error_t tx_parse_received(bool last) {
+    if (tx_get_buffer() != tx_parsed_buffer) {
+        MEMZERO(&tx_obj, sizeof(tx_obj));
+        tx_parsed_buffer = tx_get_buffer();
+    }
+
+    return parser_parse_chunk(&ctx_parsed_tx, tx_get_buffer(), tx_get_buffer_length(), &tx_obj, last);
+}
+
+const char *tx_parse_chunk() {
+    const parser_error_t err = tx_parse_received(false);
+    CHECK_APP_CANARY()
+
+    if (err != parser_ok) {
+        return parser_getErrorDescription(err);
+    }
 
-    uint8_t err = parser_parse(&ctx_parsed_tx, tx_get_buffer(), tx_get_buffer_length(), &tx_obj);
+    return NULL;
+}
+
+const char *tx_parse(uint8_t *error_code) {
+    // handleSign derives the change address of the signing path before the last chunk is parsed
+    parser_set_change_address(change_address, sizeof(change_address));
+    uint8_t err = tx_parse_received(true);
 
     CHECK_APP_CANARY()
 
@@ -63,6 +170,12 @@ const char *tx_parse(uint8_t *error_code) {
         return parser_getErrorDescription(err);
     }
 
+    // Share the digest computed while receiving the tx with the Hash item
+    uint8_t digest[TX_HASH_LEN] = {0};
+    if (tx_get_sha256_digest(digest, sizeof(digest)) == zxerr_ok) {
+        parser_set_tx_hash(&ctx_parsed_tx, digest, sizeof(digest));
+    }
+
     err = parser_validate(&ctx_parsed_tx);
     *error_code = err;
     CHECK_APP_CANARY()
@@ -74,7 +187,10 @@ const char *tx_parse(uint8_t *error_code) {
     return NULL;
 }
 
-void tx_parse_reset() { MEMZERO(&tx_obj, sizeof(tx_obj)); }
+void tx_parse_reset() {
+    MEMZERO(&tx_obj, sizeof(tx_obj));
+    tx_parsed_buffer = NULL;
+}
 
 zxerr_t tx_getNumItems(uint8_t *num_items) {
     parser_error_t err = parser_getNumItems(&ctx_parsed_tx, num_items);
@@ -110,3 +226,26 @@ zxerr_t tx_getItem(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *ou
 
     return zxerr_ok;
 }
+
+zxerr_t tx_getItemPageCount(int8_t displayIdx, uint16_t outValLen, uint8_t *pageCount) {
+    uint8_t numItems = 0;
+
+    CHECK_ZXERR(tx_getNumItems(&numItems))
+
+    if (displayIdx < 0 || displayIdx >= numItems) {
+        return zxerr_no_data;
+    }
+
+    parser_error_t err = parser_getItemPageCount(&ctx_parsed_tx, displayIdx, outValLen, pageCount);
+
+    // Convert error codes
+    if (err == parser_no_data || err == parser_display_idx_out_of_range || err == parser_display_page_out_of_range) {
+        return zxerr_no_data;
+    }
+
+    if (err != parser_ok) {
+        return zxerr_unknown;
+    }
+
+    return zxerr_ok;
+}
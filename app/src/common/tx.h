@@ -15,10 +15,18 @@
  ********************************************************************************/
 #pragma once
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include "coin.h"
-#include "os.h"
+#include "crypto_helper.h"
 #include "zxerror.h"
 
+#if defined(LEDGER_SPECIFIC)
+#include "os.h"
+#endif
+
 void tx_initialize();
 
 /// Clears the transaction buffer
@@ -39,6 +47,23 @@ uint32_t tx_get_buffer_length();
 /// \return
 uint8_t *tx_get_buffer();
 
+/// Selects the digest computed while the transaction is appended, from the next tx_reset on
+/// \param kind digest the instruction being served consumes
+void tx_select_digest(crypto_digest_kind_e kind);
+
+/// Returns the SHA-256 digest of the transaction buffer, computed while it was appended
+/// \return zxerr_ok if the digest covers the whole buffer and SHA-256 was selected
+zxerr_t tx_get_sha256_digest(uint8_t *digest, uint16_t digestLen);
+
+/// Returns the Keccak-256 digest of the transaction buffer, computed while it was appended
+/// \return zxerr_ok if the digest covers the whole buffer and Keccak-256 was selected
+zxerr_t tx_get_keccak_digest(uint8_t *digest, uint16_t digestLen);
+
+/// Parse the part of the transaction received so far
+/// Parsing resumes where the previous chunk left off, so malformed data is rejected early.
+/// \return It returns NULL if data is valid so far or error message otherwise.
+const char *tx_parse_chunk();
+
 /// Parse message stored in transaction buffer
 /// This function should be called as soon as full buffer data is loaded.
 /// \return It returns NULL if data is valid or error message otherwise.
@@ -50,3 +75,10 @@ zxerr_t tx_getNumItems(uint8_t *num_items);
 /// Gets an specific item from the transaction (including paging)
 zxerr_t tx_getItem(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outValue, uint16_t outValueLen,
                    uint8_t pageIdx, uint8_t *pageCount);
+
+/// Gets the number of pages of an item, without rendering it when its length is known
+zxerr_t tx_getItemPageCount(int8_t displayIdx, uint16_t outValLen, uint8_t *pageCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,7 @@
 
 #include "crypto.h"
 
+#include "bip32_cache.h"
 #include "coin.h"
 #include "crypto_helper.h"
 #include "cx.h"
@@ -26,11 +27,13 @@
 uint32_t hdPath[MAX_BIP32_PATH];
 uint32_t hdPath_len;
 uint8_t change_address[20];
+signature_format_e signature_format = signature_rsv;
 #include <bech32.h>
 
 #define MAX_DER_SIGNATURE_LEN 73
 
-zxerr_t crypto_extractUncompressedPublicKey(uint8_t *pubKey, uint16_t pubKeyLen, uint8_t *chainCode) {
+static zxerr_t extractUncompressedPublicKeyOfPath(const uint32_t *path, uint32_t path_len, uint8_t *pubKey,
+                                                  uint16_t pubKeyLen, uint8_t *chainCode) {
     if (pubKey == NULL || pubKeyLen < PK_LEN_SECP256K1_UNCOMPRESSED) {
         return zxerr_invalid_crypto_settings;
     }
@@ -40,8 +43,9 @@ zxerr_t crypto_extractUncompressedPublicKey(uint8_t *pubKey, uint16_t pubKeyLen,
 
     zxerr_t error = zxerr_unknown;
 
-    CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(HDW_NORMAL, CX_CURVE_256K1, hdPath, hdPath_len, privateKeyData,
-                                                     chainCode, NULL, 0));
+    if (bip32_cache_derive(path, path_len, privateKeyData, chainCode) != zxerr_ok) {
+        goto catch_cx_error;
+    }
 
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_256K1, privateKeyData, 32, &cx_privateKey));
     CATCH_CXERROR(cx_ecfp_init_public_key_no_throw(CX_CURVE_256K1, NULL, 0, &cx_publicKey));
@@ -54,12 +58,17 @@ catch_cx_error:
     MEMZERO(privateKeyData, sizeof(privateKeyData));
 
     if (error != zxerr_ok) {
+        bip32_cache_wipe();
         MEMZERO(pubKey, pubKeyLen);
     }
 
     return error;
 }
 
+zxerr_t crypto_extractUncompressedPublicKey(uint8_t *pubKey, uint16_t pubKeyLen, uint8_t *chainCode) {
+    return extractUncompressedPublicKeyOfPath(hdPath, hdPath_len, pubKey, pubKeyLen, chainCode);
+}
+
 __Z_INLINE zxerr_t compressPubkey(const uint8_t *pubkey, uint16_t pubkeyLen, uint8_t *output, uint16_t outputLen) {
     if (pubkey == NULL || output == NULL || pubkeyLen != PK_LEN_SECP256K1_UNCOMPRESSED || outputLen < PK_LEN_SECP256K1) {
         return zxerr_invalid_crypto_settings;
@@ -70,6 +79,55 @@ __Z_INLINE zxerr_t compressPubkey(const uint8_t *pubkey, uint16_t pubkeyLen, uin
     return zxerr_ok;
 }
 
+// Public key and change address of the last derived path. Deriving a key costs a BIP32
+// derivation and a point multiplication, so they are kept for the app session and only
+// recomputed for another path.
+typedef struct {
+    bool valid;
+    uint32_t path[MAX_BIP32_PATH];
+    uint32_t path_len;
+    uint8_t pubkey[PK_LEN_SECP256K1];
+    uint8_t address[sizeof(change_address)];
+} key_cache_t;
+
+static key_cache_t key_cache;
+
+void crypto_key_cache_invalidate(void) { MEMZERO(&key_cache, sizeof(key_cache)); }
+
+static bool key_cache_matches(void) {
+    return key_cache.valid && key_cache.path_len == hdPath_len && hdPath_len <= MAX_BIP32_PATH &&
+           MEMCMP(key_cache.path, hdPath, sizeof(uint32_t) * hdPath_len) == 0;
+}
+
+// Compressed public key and change address of hdPath, derived on the first use of the path
+static zxerr_t crypto_cachedKey(void) {
+    if (key_cache_matches()) {
+        return zxerr_ok;
+    }
+    crypto_key_cache_invalidate();
+    if (hdPath_len > MAX_BIP32_PATH) {
+        return zxerr_invalid_crypto_settings;
+    }
+
+    uint8_t uncompressedPubkey[PK_LEN_SECP256K1_UNCOMPRESSED] = {0};
+    CHECK_ZXERR(crypto_extractUncompressedPublicKey(uncompressedPubkey, sizeof(uncompressedPubkey), NULL));
+    CHECK_ZXERR(compressPubkey(uncompressedPubkey, sizeof(uncompressedPubkey), key_cache.pubkey, sizeof(key_cache.pubkey)));
+
+    // Hash it
+    uint8_t hashed1_pk[CX_SHA256_SIZE] = {0};
+    crypto_sha256(key_cache.pubkey, PK_LEN_SECP256K1, hashed1_pk, CX_SHA256_SIZE);
+    const zxerr_t err = ripemd160_32(key_cache.address, hashed1_pk);
+    if (err != zxerr_ok) {
+        crypto_key_cache_invalidate();
+        return err;
+    }
+
+    MEMCPY(key_cache.path, hdPath, sizeof(uint32_t) * hdPath_len);
+    key_cache.path_len = hdPath_len;
+    key_cache.valid = true;
+    return zxerr_ok;
+}
+
 typedef struct {
     uint8_t r[32];
     uint8_t s[32];
@@ -82,7 +140,7 @@ typedef struct {
 } __attribute__((packed)) signature_t;
 
 zxerr_t crypto_sign(uint8_t *signature, uint16_t signatureMaxlen, uint16_t *sigSize, bool hash) {
-    if (signature == NULL || sigSize == NULL) {
+    if (signature == NULL || sigSize == NULL || signatureMaxlen < sizeof(signature_t)) {
         return zxerr_invalid_crypto_settings;
     }
     uint8_t messageDigest[CX_SHA256_SIZE] = {0};
@@ -92,7 +150,8 @@ zxerr_t crypto_sign(uint8_t *signature, uint16_t signatureMaxlen, uint16_t *sigS
     const uint8_t *message = tx_get_buffer();
     const uint16_t messageLen = tx_get_buffer_length();
     if (!hash) {
-        crypto_sha256(message, messageLen, messageDigest, CX_SHA256_SIZE);
+        // Digest was computed while the transaction was received
+        CHECK_ZXERR(tx_get_sha256_digest(messageDigest, sizeof(messageDigest)))
     } else {
         // Defensive bound: messageDigest is a 32-byte stack buffer adjacent
         // to the private-key material below. The only current hash=true
@@ -106,35 +165,52 @@ zxerr_t crypto_sign(uint8_t *signature, uint16_t signatureMaxlen, uint16_t *sigS
 
     cx_ecfp_private_key_t cx_privateKey = {0};
     uint8_t privateKeyData[64] = {0};
-    unsigned int info = 0;
-    uint32_t signatureLength = sizeof_field(signature_t, der_signature);
+    uint32_t info = 0;
     signature_t *const signature_object = (signature_t *)(signature);
     *sigSize = 0;
 
     zxerr_t error = zxerr_unknown;
 
     // Generate keys
-    CATCH_CXERROR(
-        os_derive_bip32_with_seed_no_throw(HDW_NORMAL, CX_CURVE_256K1, hdPath, hdPath_len, privateKeyData, NULL, NULL, 0));
+    if (bip32_cache_derive(hdPath, hdPath_len, privateKeyData, NULL) != zxerr_ok) {
+        goto catch_cx_error;
+    }
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_256K1, privateKeyData, 32, &cx_privateKey));
 
-    // Sign
-    CATCH_CXERROR(cx_ecdsa_sign_no_throw(&cx_privateKey, CX_RND_RFC6979 | CX_LAST, CX_SHA256, messageDigest, CX_SHA256_SIZE,
-                                         signature_object->der_signature, &signatureLength, &info));
+    // Sign straight into fixed size r and s, then drop the private key
+    CATCH_CXERROR(cx_ecdsa_sign_rs_no_throw(&cx_privateKey, CX_RND_RFC6979 | CX_LAST, CX_SHA256, messageDigest,
+                                            CX_SHA256_SIZE, sizeof_field(signature_t, r), signature_object->r,
+                                            signature_object->s, &info));
+    MEMZERO(&cx_privateKey, sizeof(cx_privateKey));
+    MEMZERO(privateKeyData, sizeof(privateKeyData));
 
-    const err_convert_e err_c = convertDERtoRSV(signature_object->der_signature, info, signature_object->r,
-                                                signature_object->s, &signature_object->v);
-    if (err_c != no_error) {
-        error = zxerr_unknown;
-    } else {
-        *sigSize = sizeof_field(signature_t, r) + sizeof_field(signature_t, s) + sizeof_field(signature_t, v);
-        error = zxerr_ok;
+    // Recovery id, as convertDERtoRSV used to derive it from the same flags
+    signature_object->v = 0;
+    if (info & CX_ECCINFO_PARITY_ODD) {
+        signature_object->v |= 0x01;
+    }
+    if (info & CX_ECCINFO_xGTn) {
+        signature_object->v |= 0x02;
+    }
+    *sigSize = sizeof_field(signature_t, r) + sizeof_field(signature_t, s) + sizeof_field(signature_t, v);
+    error = zxerr_ok;
+
+    if (signature_format == signature_rsv_der) {
+        const uint8_t derLen = crypto_encodeDER(signature_object->r, signature_object->s, signature_object->der_signature,
+                                                sizeof_field(signature_t, der_signature));
+        if (derLen == 0) {
+            *sigSize = 0;
+            error = zxerr_encoding_failed;
+        } else {
+            *sigSize += derLen;
+        }
     }
 
 catch_cx_error:
     MEMZERO(&cx_privateKey, sizeof(cx_privateKey));
     MEMZERO(privateKeyData, sizeof(privateKeyData));
     if (error != zxerr_ok) {
+        bip32_cache_wipe();
         MEMZERO(signature, signatureMaxlen);
     }
     return error;
@@ -147,9 +223,8 @@ zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrRe
     }
 
     char *addr = (char *)(buffer + PK_LEN_SECP256K1);
-    uint8_t uncompressedPubkey[PK_LEN_SECP256K1_UNCOMPRESSED] = {0};
-    CHECK_ZXERR(crypto_extractUncompressedPublicKey(uncompressedPubkey, sizeof(uncompressedPubkey), NULL));
-    CHECK_ZXERR(compressPubkey(uncompressedPubkey, sizeof(uncompressedPubkey), buffer, bufferLen));
+    CHECK_ZXERR(crypto_cachedKey());
+    MEMCPY(buffer, key_cache.pubkey, PK_LEN_SECP256K1);
 
     const uint8_t outLen = crypto_encodePubkey(buffer, addr, bufferLen - PK_LEN_SECP256K1);
 
@@ -162,17 +237,116 @@ zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrRe
     return zxerr_ok;
 }
 
-zxerr_t crypto_get_address(void) {
+zxerr_t crypto_fillAddressOfPath(const uint32_t *path, uint32_t path_len, uint8_t *buffer, uint16_t bufferLen,
+                                 uint16_t *addrResponseLen) {
+    if (path == NULL || buffer == NULL || addrResponseLen == NULL || bufferLen < PK_LEN_SECP256K1 + 50) {
+        return zxerr_invalid_crypto_settings;
+    }
+
     uint8_t uncompressedPubkey[PK_LEN_SECP256K1_UNCOMPRESSED] = {0};
-    uint8_t compressedPubkey[PK_LEN_SECP256K1] = {0};
-    CHECK_ZXERR(crypto_extractUncompressedPublicKey(uncompressedPubkey, sizeof(uncompressedPubkey), NULL));
-    CHECK_ZXERR(compressPubkey(uncompressedPubkey, sizeof(uncompressedPubkey), compressedPubkey, sizeof(compressedPubkey)));
+    CHECK_ZXERR(extractUncompressedPublicKeyOfPath(path, path_len, uncompressedPubkey, sizeof(uncompressedPubkey), NULL))
+    CHECK_ZXERR(compressPubkey(uncompressedPubkey, sizeof(uncompressedPubkey), buffer, bufferLen))
 
-    // Hash it
-    uint8_t hashed1_pk[CX_SHA256_SIZE] = {0};
-    crypto_sha256(compressedPubkey, PK_LEN_SECP256K1, hashed1_pk, CX_SHA256_SIZE);
+    const uint8_t outLen = crypto_encodePubkey(buffer, (char *)(buffer + PK_LEN_SECP256K1), bufferLen - PK_LEN_SECP256K1);
+    if (outLen == 0) {
+        MEMZERO(buffer, bufferLen);
+        return zxerr_encoding_failed;
+    }
 
-    CHECK_ZXERR(ripemd160_32(change_address, hashed1_pk))
+    *addrResponseLen = PK_LEN_SECP256K1 + outLen;
+    return zxerr_ok;
+}
 
+zxerr_t crypto_fillXpub(uint8_t *buffer, uint16_t bufferLen, uint16_t *xpubResponseLen) {
+    if (buffer == NULL || xpubResponseLen == NULL || bufferLen < PK_LEN_SECP256K1 + CHAIN_CODE_LEN ||
+        hdPath_len != HDPATH_LEN_ACCOUNT) {
+        return zxerr_invalid_crypto_settings;
+    }
+
+    uint8_t uncompressedPubkey[PK_LEN_SECP256K1_UNCOMPRESSED] = {0};
+    zxerr_t err = crypto_extractUncompressedPublicKey(uncompressedPubkey, sizeof(uncompressedPubkey),
+                                                      buffer + PK_LEN_SECP256K1);
+    if (err == zxerr_ok) {
+        err = compressPubkey(uncompressedPubkey, sizeof(uncompressedPubkey), buffer, bufferLen);
+    }
+    if (err != zxerr_ok) {
+        MEMZERO(buffer, bufferLen);
+        return err;
+    }
+
+    *xpubResponseLen = PK_LEN_SECP256K1 + CHAIN_CODE_LEN;
     return zxerr_ok;
 }
+
+zxerr_t crypto_get_address(void) {
+    CHECK_ZXERR(crypto_cachedKey());
+    MEMCPY(change_address, key_cache.address, sizeof(change_address));
+    return zxerr_ok;
+}
+
+// Primitives of the bip32 parent node cache
+
+// Order of the secp256k1 group
+static const uint8_t secp256k1_order[BIP32_KEY_LEN] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+    0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41};
+
+zxerr_t bip32_derive_node(const uint32_t *path, uint32_t path_len, uint8_t *private_key, uint8_t *chain_code) {
+    uint8_t privateKeyData[64] = {0};
+    zxerr_t error = zxerr_unknown;
+
+    CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(HDW_NORMAL, CX_CURVE_256K1, path, path_len, privateKeyData,
+                                                     chain_code, NULL, 0));
+    MEMCPY(private_key, privateKeyData, BIP32_KEY_LEN);
+    error = zxerr_ok;
+
+catch_cx_error:
+    MEMZERO(privateKeyData, sizeof(privateKeyData));
+    return error;
+}
+
+zxerr_t bip32_public_key(const uint8_t *private_key, uint8_t *public_key) {
+    cx_ecfp_public_key_t cx_publicKey = {0};
+    cx_ecfp_private_key_t cx_privateKey = {0};
+    zxerr_t error = zxerr_unknown;
+
+    CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_256K1, private_key, BIP32_KEY_LEN, &cx_privateKey));
+    CATCH_CXERROR(cx_ecfp_init_public_key_no_throw(CX_CURVE_256K1, NULL, 0, &cx_publicKey));
+    CATCH_CXERROR(cx_ecfp_generate_pair_no_throw(CX_CURVE_256K1, &cx_publicKey, &cx_privateKey, 1));
+    error = compressPubkey(cx_publicKey.W, PK_LEN_SECP256K1_UNCOMPRESSED, public_key, BIP32_PUBKEY_LEN);
+
+catch_cx_error:
+    MEMZERO(&cx_privateKey, sizeof(cx_privateKey));
+    return error;
+}
+
+zxerr_t bip32_hmac_sha512(const uint8_t *key, const uint8_t *data, uint16_t dataLen, uint8_t *mac) {
+    cx_hmac_sha512_t hmac;
+    zxerr_t error = zxerr_unknown;
+
+    CATCH_CXERROR(cx_hmac_sha512_init_no_throw(&hmac, key, BIP32_CHAIN_CODE_LEN));
+    CATCH_CXERROR(cx_hmac_no_throw((cx_hmac_t *)&hmac, CX_LAST, data, dataLen, mac, BIP32_KEY_LEN + BIP32_CHAIN_CODE_LEN));
+    error = zxerr_ok;
+
+catch_cx_error:
+    MEMZERO(&hmac, sizeof(hmac));
+    return error;
+}
+
+zxerr_t bip32_scalar_add(const uint8_t *tweak, uint8_t *private_key) {
+    int diff = 0;
+    zxerr_t error = zxerr_unknown;
+
+    // A tweak past the group order makes the index invalid
+    CATCH_CXERROR(cx_math_cmp_no_throw(tweak, secp256k1_order, BIP32_KEY_LEN, &diff));
+    if (diff >= 0) {
+        goto catch_cx_error;
+    }
+    CATCH_CXERROR(cx_math_addm_no_throw(private_key, tweak, private_key, secp256k1_order, BIP32_KEY_LEN));
+    if (!cx_math_is_zero(private_key, BIP32_KEY_LEN)) {
+        error = zxerr_ok;
+    }
+
+catch_cx_error:
+    return error;
+}
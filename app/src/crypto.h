@@ -29,11 +29,20 @@ extern "C" {
 extern uint32_t hdPath[MAX_BIP32_PATH];
 extern uint32_t hdPath_len;
 extern uint8_t change_address[20];
+extern signature_format_e signature_format;
 
 zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrResponseLen);
+// Same reply as crypto_fillAddress for path, leaving hdPath and its cached key alone
+zxerr_t crypto_fillAddressOfPath(const uint32_t *path, uint32_t path_len, uint8_t *buffer, uint16_t bufferLen,
+                                 uint16_t *addrResponseLen);
+// Compressed public key and chain code of the account node in hdPath
+zxerr_t crypto_fillXpub(uint8_t *buffer, uint16_t bufferLen, uint16_t *xpubResponseLen);
 zxerr_t crypto_sign(uint8_t *signature, uint16_t signatureMaxlen, uint16_t *sigSize, bool hash);
 zxerr_t crypto_get_address(void);
 
+// Drops the public key and change address kept for the last derived path
+void crypto_key_cache_invalidate(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,7 +15,7 @@
  ********************************************************************************/
 #include "crypto_helper.h"
 
-#include "bech32.h"
+#include "bech32_address.h"
 #include "coin.h"
 #include "zxformat.h"
 
@@ -51,6 +51,85 @@ zxerr_t crypto_sha256(const uint8_t *input, uint16_t inputLen, uint8_t *output,
     return zxerr_ok;
 }
 
+zxerr_t crypto_digest_init(crypto_digest_t *ctx, crypto_digest_kind_e kind) {
+    if (ctx == NULL) {
+        return zxerr_encoding_failed;
+    }
+    MEMZERO(ctx, sizeof(*ctx));
+
+    switch (kind) {
+        case crypto_digest_none:
+            break;
+        case crypto_digest_sha256:
+#if defined(LEDGER_SPECIFIC)
+            CHECK_CX_OK(cx_sha256_init_no_throw(&ctx->state.sha256));
+#else
+            picohash_init_sha256(&ctx->state.sha256);
+#endif
+            break;
+#if defined(LEDGER_SPECIFIC)
+        case crypto_digest_keccak256:
+            CHECK_CX_OK(cx_keccak_init_no_throw(&ctx->state.keccak, KECCAK_256_SIZE * 8));
+            break;
+#endif
+        default:
+            return zxerr_invalid_crypto_settings;
+    }
+    ctx->kind = kind;
+    return zxerr_ok;
+}
+
+zxerr_t crypto_digest_update(crypto_digest_t *ctx, const uint8_t *input, uint16_t inputLen) {
+    if (ctx == NULL || (input == NULL && inputLen > 0)) {
+        return zxerr_encoding_failed;
+    }
+
+    switch (ctx->kind) {
+        case crypto_digest_none:
+            return zxerr_ok;
+        case crypto_digest_sha256:
+#if defined(LEDGER_SPECIFIC)
+            CHECK_CX_OK(cx_hash_no_throw(&ctx->state.sha256.header, 0, input, inputLen, NULL, 0));
+#else
+            picohash_update(&ctx->state.sha256, input, inputLen);
+#endif
+            return zxerr_ok;
+#if defined(LEDGER_SPECIFIC)
+        case crypto_digest_keccak256:
+            CHECK_CX_OK(cx_hash_no_throw(&ctx->state.keccak.header, 0, input, inputLen, NULL, 0));
+            return zxerr_ok;
+#endif
+        default:
+            return zxerr_invalid_crypto_settings;
+    }
+}
+
+zxerr_t crypto_digest_final(crypto_digest_t *ctx, uint8_t *digest, uint16_t digestLen) {
+    if (ctx == NULL || digest == NULL || digestLen < CX_SHA256_SIZE) {
+        return zxerr_encoding_failed;
+    }
+
+    MEMZERO(digest, digestLen);
+
+    switch (ctx->kind) {
+        case crypto_digest_sha256:
+#if defined(LEDGER_SPECIFIC)
+            CHECK_CX_OK(cx_hash_no_throw(&ctx->state.sha256.header, CX_LAST, NULL, 0, digest, CX_SHA256_SIZE));
+#else
+            picohash_final(&ctx->state.sha256, digest);
+#endif
+            return zxerr_ok;
+#if defined(LEDGER_SPECIFIC)
+        case crypto_digest_keccak256:
+            CHECK_CX_OK(cx_hash_no_throw(&ctx->state.keccak.header, CX_LAST, NULL, 0, digest, KECCAK_256_SIZE));
+            return zxerr_ok;
+#endif
+        default:
+            // Nothing was hashed
+            return zxerr_no_data;
+    }
+}
+
 zxerr_t ripemd160_32(uint8_t *out, uint8_t *in) {
 #if defined(LEDGER_SPECIFIC)
     cx_ripemd160_t rip160 = {0};
@@ -60,6 +139,43 @@ zxerr_t ripemd160_32(uint8_t *out, uint8_t *in) {
     return zxerr_ok;
 }
 
+// INTEGER holding a 32-byte big-endian value: leading zeros dropped, and a zero
+// prepended when the top bit is set so it stays positive
+static uint8_t der_integer(const uint8_t *value, uint8_t *out) {
+    uint8_t start = 0;
+    while (start < 31 && value[start] == 0) {
+        start++;
+    }
+    const uint8_t pad = (value[start] & 0x80) ? 1 : 0;
+    const uint8_t len = (uint8_t)(32 - start + pad);
+
+    out[0] = 0x02;
+    out[1] = len;
+    out[2] = 0;
+    MEMCPY(out + 2 + pad, value + start, 32 - start);
+    return 2 + len;
+}
+
+uint8_t crypto_encodeDER(const uint8_t *r, const uint8_t *s, uint8_t *out, uint16_t outLen) {
+    // SEQUENCE of two INTEGERs of up to 33 bytes each
+    uint8_t der[2 + 2 * (2 + 33)] = {0};
+    if (r == NULL || s == NULL || out == NULL) {
+        return 0;
+    }
+
+    uint8_t len = 2;
+    len += der_integer(r, der + len);
+    len += der_integer(s, der + len);
+    der[0] = 0x30;
+    der[1] = len - 2;
+
+    if (outLen < len) {
+        return 0;
+    }
+    MEMCPY(out, der, len);
+    return len;
+}
+
 uint8_t crypto_encodePubkey(const uint8_t *pubkey, char *out, uint16_t out_len) {
     if (pubkey == NULL || out == NULL) {
         return 0;
@@ -72,7 +188,10 @@ uint8_t crypto_encodePubkey(const uint8_t *pubkey, char *out, uint16_t out_len)
     uint8_t hashed2_pk[CX_RIPEMD160_SIZE] = {0};
     CHECK_ZXERR(ripemd160_32(hashed2_pk, hashed1_pk))
 
-    CHECK_ZXERR(bech32EncodeFromBytes(out, out_len, bech32_hrp, hashed2_pk, CX_RIPEMD160_SIZE, 1, BECH32_ENCODING_BECH32))
+    const uint8_t hrp_len = (uint8_t)strnlen(bech32_hrp, sizeof(bech32_hrp));
+    uint32_t hrp_state = 0;
+    CHECK_ZXERR(bech32_hrp_state(bech32_hrp, hrp_len, &hrp_state))
+    CHECK_ZXERR(bech32_encode_address(out, out_len, bech32_hrp, hrp_len, hrp_state, hashed2_pk))
 
     return strlen(out);
 }
@@ -26,6 +26,12 @@ extern "C" {
 #include "parser_common.h"
 #include "zxerror.h"
 
+#if defined(LEDGER_SPECIFIC)
+#include "cx.h"
+#else
+#include "picohash.h"
+#endif
+
 #define KECCAK_256_SIZE 32
 
 #define CHECK_CX_OK(CALL)         \
@@ -48,6 +54,34 @@ uint8_t crypto_encodePubkey(const uint8_t *pubkey, char *out, uint16_t out_len);
 zxerr_t crypto_sha256(const uint8_t *input, uint16_t inputLen, uint8_t *output, uint16_t outputLen);
 
 zxerr_t ripemd160_32(uint8_t *out, uint8_t *in);
+
+// DER encoding of a signature given as fixed 32-byte r and s. Returns its length, 0 if out is too short.
+uint8_t crypto_encodeDER(const uint8_t *r, const uint8_t *s, uint8_t *out, uint16_t outLen);
+
+// Running digest of the transaction buffer, fed chunk by chunk as it is received.
+// Only the digest the current instruction consumes is kept. Keccak-256 is only available on device.
+typedef enum {
+    crypto_digest_none = 0,
+    crypto_digest_sha256,
+    crypto_digest_keccak256,
+} crypto_digest_kind_e;
+
+typedef struct {
+    crypto_digest_kind_e kind;
+    union {
+#if defined(LEDGER_SPECIFIC)
+        cx_sha256_t sha256;
+        cx_sha3_t keccak;
+#else
+        picohash_ctx_t sha256;
+#endif
+    } state;
+} crypto_digest_t;
+
+zxerr_t crypto_digest_init(crypto_digest_t *ctx, crypto_digest_kind_e kind);
+zxerr_t crypto_digest_update(crypto_digest_t *ctx, const uint8_t *input, uint16_t inputLen);
+// Writes the 32-byte digest of the kind the context was initialized with
+zxerr_t crypto_digest_final(crypto_digest_t *ctx, uint8_t *digest, uint16_t digestLen);
 #ifdef __cplusplus
 }
 #endif
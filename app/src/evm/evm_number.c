@@ -0,0 +1,127 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "evm_number.h"
+
+#include <string.h>
+
+#include "parser_print_common.h"
+#include "zxformat.h"
+#include "zxmacros.h"
+
+// Wide numbers are split in chunks of 9 digits. 10^9 keeps every step of the long division
+// within 64 bits, so no 128-bit arithmetic is needed on the device.
+#define CHUNK_DIGITS 9
+#define CHUNK_BASE 1000000000U
+
+#define LIMB_LEN sizeof(uint32_t)
+#define MAX_LIMBS (EVM_NUMBER_MAX_LEN / LIMB_LEN)
+
+// Writes the digits of number so that they end right before end and returns how many were written
+static uint8_t write_number_digits(char *end, const uint8_t *number, uint16_t numberLen) {
+    // Leading zero bytes carry no digits
+    while (numberLen > 0 && number[0] == 0) {
+        number++;
+        numberLen--;
+    }
+
+    if (numberLen <= sizeof(uint64_t)) {
+        uint64_t value = 0;
+        for (uint16_t i = 0; i < numberLen; i++) {
+            value = (value << 8) | number[i];
+        }
+        const uint8_t n_digits = count_u64_digits(value);
+        write_u64_digits(end, value, n_digits);
+        return n_digits;
+    }
+
+    // 32-bit limbs, most significant first
+    uint32_t limbs[MAX_LIMBS] = {0};
+    const uint8_t n_limbs = (uint8_t)((numberLen + LIMB_LEN - 1) / LIMB_LEN);
+    for (uint16_t i = 0; i < numberLen; i++) {
+        const uint16_t shift = numberLen - 1 - i;
+        limbs[n_limbs - 1 - shift / LIMB_LEN] |= (uint32_t)number[i] << (8 * (shift % LIMB_LEN));
+    }
+
+    uint8_t written = 0;
+    uint8_t first = 0;
+    while (first < n_limbs) {
+        uint64_t rem = 0;
+        for (uint8_t i = first; i < n_limbs; i++) {
+            const uint64_t cur = (rem << 32) | limbs[i];
+            limbs[i] = (uint32_t)(cur / CHUNK_BASE);
+            rem = cur % CHUNK_BASE;
+        }
+        while (first < n_limbs && limbs[first] == 0) {
+            first++;
+        }
+
+        // Inner chunks keep their leading zeros
+        const uint8_t n_digits = first < n_limbs ? CHUNK_DIGITS : count_u64_digits(rem);
+        write_u64_digits(end - written, rem, n_digits);
+        written += n_digits;
+    }
+    return written;
+}
+
+parser_error_t evm_number_to_str(const uint8_t *number, uint16_t numberLen, uint8_t decimals, char *out, uint16_t outLen) {
+    if ((number == NULL && numberLen > 0) || out == NULL || outLen == 0) {
+        return parser_unexpected_error;
+    }
+    if (numberLen > EVM_NUMBER_MAX_LEN || decimals >= EVM_NUMBER_MAX_DIGITS) {
+        return parser_value_out_of_range;
+    }
+
+    // Zero padded so that a fraction wider than the number reads its leading zeros
+    char digits[EVM_NUMBER_MAX_DIGITS + 1];
+    memset(digits, '0', sizeof(digits));
+    char *end = digits + sizeof(digits);
+    uint8_t n_digits = write_number_digits(end, number, numberLen);
+    if (n_digits <= decimals) {
+        n_digits = decimals + 1;
+    }
+
+    const char *whole = end - n_digits;
+    const uint8_t whole_len = n_digits - decimals;
+    uint8_t fraction_len = decimals;
+    while (fraction_len > 1 && end[fraction_len - decimals - 1] == '0') {
+        fraction_len--;
+    }
+
+    const uint16_t len = whole_len + (decimals > 0 ? 1 + fraction_len : 0);
+    if (len >= outLen) {
+        return parser_unexpected_buffer_end;
+    }
+    MEMCPY(out, whole, whole_len);
+    if (decimals > 0) {
+        out[whole_len] = '.';
+        MEMCPY(out + whole_len + 1, end - decimals, fraction_len);
+    }
+    out[len] = '\0';
+    return parser_ok;
+}
+
+parser_error_t printEvmNumber(const uint8_t *number, uint16_t numberLen, uint8_t decimals, const char *prefix,
+                              char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    char bufferUI[100] = {0};
+    const size_t prefixLen = prefix != NULL ? strnlen(prefix, sizeof(bufferUI) - EVM_NUMBER_MAX_DIGITS - 2) : 0;
+    if (prefixLen > 0) {
+        MEMCPY(bufferUI, prefix, prefixLen);
+    }
+    CHECK_ERROR(evm_number_to_str(number, numberLen, decimals, bufferUI + prefixLen, sizeof(bufferUI) - prefixLen))
+
+    pageString(outVal, outValLen, bufferUI, pageIdx, pageCount);
+    return parser_ok;
+}
@@ -0,0 +1,40 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "parser_common.h"
+
+// RLP numbers are big-endian and at most 32 bytes wide, up to 78 decimal digits
+#define EVM_NUMBER_MAX_LEN 32
+#define EVM_NUMBER_MAX_DIGITS 78
+
+// Writes number[0..numberLen) in decimal. With decimals > 0 the point is inserted and the
+// trailing zeros of the fraction are trimmed, keeping one digit after the point.
+parser_error_t evm_number_to_str(const uint8_t *number, uint16_t numberLen, uint8_t decimals, char *out, uint16_t outLen);
+
+// Pages prefix (may be NULL) followed by the decimal form of number
+parser_error_t printEvmNumber(const uint8_t *number, uint16_t numberLen, uint8_t decimals, const char *prefix,
+                              char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
+
+#ifdef __cplusplus
+}
+#endif
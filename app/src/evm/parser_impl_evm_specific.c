@@ -20,17 +20,24 @@
 
 #include "app_mode.h"
 #include "coin.h"
+#include "crypto_helper.h"
 #include "evm_erc20.h"
+#include "evm_number.h"
 #include "evm_utils.h"
+#include "networks.h"
+#include "parser_print_common.h"
 #include "zxformat.h"
+#include "zxmacros.h"
+
+#if defined(LEDGER_SPECIFIC)
+#include "tx.h"
+#endif
 
 #define SUPPORTED_NETWORKS_EVM_LEN 4
-#define FLARE_MAINNET_CHAINID 14
-#define COSTON_CHAINID 16
-#define SONG_BIRD_CHAINID 19
-#define COSTON2_CHAINID 114
 #define TMP_DATA_ARRAY_SIZE 40
 #define ERC20_TRANSFER_OFFSET 4 + 12
+#define ERC20_AMOUNT_OFFSET (4 + 32)
+#define ERC20_AMOUNT_LEN 32
 
 const uint64_t supported_networks_evm[SUPPORTED_NETWORKS_EVM_LEN] = {FLARE_MAINNET_CHAINID, COSTON_CHAINID,
                                                                      SONG_BIRD_CHAINID, COSTON2_CHAINID};
@@ -51,222 +58,247 @@ const erc20_tokens_t supportedTokens[] = {
 const uint8_t supportedTokensSize = sizeof(supportedTokens) / sizeof(supportedTokens[0]);
 
 static parser_error_t getNetworkName(uint64_t chainId, char *outVal, uint16_t outValLen) {
-    switch (chainId) {
-        case FLARE_MAINNET_CHAINID:
-            snprintf(outVal, outValLen, "Flare");
-            break;
-        case COSTON_CHAINID:
-            snprintf(outVal, outValLen, "Coston Flare");
-            break;
-        case SONG_BIRD_CHAINID:
-            snprintf(outVal, outValLen, "Songbird");
-            break;
-        case COSTON2_CHAINID:
-            snprintf(outVal, outValLen, "Coston2 Flare");
-            break;
-        default:
-            return parser_invalid_chain_id;
-    }
+    network_id_e network = mainnet;
+    CHECK_ERROR(network_from_evm_chain_id(chainId, &network));
+    write_str(outVal, outValLen, network_get(network)->name);
     return parser_ok;
 }
 
-parser_error_t printERC20TransferAppSpecific(const parser_context_t *ctx, const eth_tx_t *ethTxObj, uint8_t displayIdx,
-                                             char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen,
-                                             uint8_t pageIdx, uint8_t *pageCount) {
-    if (ctx == NULL || ethTxObj == NULL || outKey == NULL || outVal == NULL || pageCount == NULL) {
-        return parser_unexpected_error;
+// First DATA_BYTES_TO_PRINT bytes of the call data as hex, "..." when there is more
+static parser_error_t printData(const rlp_t *data, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    char data_array[TMP_DATA_ARRAY_SIZE];
+    writer_t w;
+    writer_init(&w, data_array, sizeof(data_array));
+    writer_append_hex(&w, data->ptr, data->rlpLen > DATA_BYTES_TO_PRINT ? DATA_BYTES_TO_PRINT : data->rlpLen);
+    if (data->rlpLen > DATA_BYTES_TO_PRINT) {
+        writer_append_str(&w, "...");
     }
 
-    if ((ethTxObj->tx_type == legacy || ethTxObj->tx_type == eip2930) && displayIdx >= 5) {
-        displayIdx += 2;
-    }
+    pageString(outVal, outValLen, data_array, pageIdx, pageCount);
+    return parser_ok;
+}
 
-    if (ethTxObj->tx_type == eip1559 && displayIdx >= 7) {
-        displayIdx++;
+// Shows the Keccak-256 digest kept by the tx layer while the tx was received,
+// so paging through the hash does not rehash the whole buffer.
+static parser_error_t printEthHashAppSpecific(const parser_context_t *ctx, char *outKey, uint16_t outKeyLen, char *outVal,
+                                              uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+#if defined(LEDGER_SPECIFIC)
+    uint8_t hash[KECCAK_256_SIZE] = {0};
+    if (ctx->buffer == tx_get_buffer() && ctx->bufferLen == tx_get_buffer_length() &&
+        tx_get_keccak_digest(hash, sizeof(hash)) == zxerr_ok) {
+        write_str(outKey, outKeyLen, "Eth-Hash");
+        pageStringHex(outVal, outValLen, (const char *)hash, sizeof(hash), pageIdx, pageCount);
+        return parser_ok;
     }
+#endif
+    return printEthHash(ctx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+}
 
-    char data_array[TMP_DATA_ARRAY_SIZE] = {0};
-    switch (displayIdx) {
-        case 0:
-            snprintf(outKey, outKeyLen, "Receiver");
-            rlp_t to = {
-                .kind = RLP_KIND_STRING, .ptr = (ethTxObj->tx.data.ptr + ERC20_TRANSFER_OFFSET), .rlpLen = ETH_ADDRESS_LEN};
-            CHECK_ERROR(printEVMAddress(&to, outVal, outValLen, pageIdx, pageCount));
-            break;
+static parser_error_t printRLPNumberAppSpecific(const rlp_t *num, char *outVal, uint16_t outValLen, uint8_t pageIdx,
+                                                uint8_t *pageCount) {
+    return printEvmNumber(num->ptr, num->rlpLen, 0, NULL, outVal, outValLen, pageIdx, pageCount);
+}
 
-        case 1:
-            snprintf(outKey, outKeyLen, "Contract");
-            rlp_t contractAddress = {.kind = RLP_KIND_STRING, .ptr = ethTxObj->tx.to.ptr, .rlpLen = ETH_ADDRESS_LEN};
-            CHECK_ERROR(printEVMAddress(&contractAddress, outVal, outValLen, pageIdx, pageCount));
-            break;
-        case 2:
-            snprintf(outKey, outKeyLen, "Coin asset");
-            CHECK_ERROR(getNetworkName(ethTxObj->chainId.chain_id_decoded, outVal, outValLen));
-            break;
-        case 3:
-            snprintf(outKey, outKeyLen, "Amount");
-            CHECK_ERROR(printERC20Value(ethTxObj, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 4:
-            snprintf(outKey, outKeyLen, "Nonce");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.nonce, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 5:
-            snprintf(outKey, outKeyLen, "Max Priority Fee");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.max_priority_fee_per_gas, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 6:
-            snprintf(outKey, outKeyLen, "Max Fee");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.max_fee_per_gas, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 7:
-            snprintf(outKey, outKeyLen, "Gas price");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.gasPrice, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 8:
-            snprintf(outKey, outKeyLen, "Gas limit");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.gasLimit, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 9:
-            snprintf(outKey, outKeyLen, "Value");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.value, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 10:
-            snprintf(outKey, outKeyLen, "Data");
-            array_to_hexstr(data_array, sizeof(data_array), ethTxObj->tx.data.ptr,
-                            ethTxObj->tx.data.rlpLen > DATA_BYTES_TO_PRINT ? DATA_BYTES_TO_PRINT : ethTxObj->tx.data.rlpLen);
-
-            if (ethTxObj->tx.data.rlpLen > DATA_BYTES_TO_PRINT) {
-                snprintf(data_array + (2 * DATA_BYTES_TO_PRINT), 4, "...");
-            }
-
-            pageString(outVal, outValLen, data_array, pageIdx, pageCount);
-            break;
-
-        case 11:
-            CHECK_ERROR(printEthHash(ctx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount));
-            break;
+// transfer(address,uint256) amount, scaled by the decimals of the token being moved
+static parser_error_t printERC20ValueAppSpecific(const eth_tx_t *ethTxObj, char *outVal, uint16_t outValLen,
+                                                 uint8_t pageIdx, uint8_t *pageCount) {
+    if (ethTxObj->tx.data.rlpLen < ERC20_AMOUNT_OFFSET + ERC20_AMOUNT_LEN || ethTxObj->tx.to.rlpLen != ETH_ADDRESS_LEN) {
+        return parser_unexpected_value;
+    }
 
-        default:
-            return parser_display_page_out_of_range;
+    for (uint8_t i = 0; i < supportedTokensSize; i++) {
+        const erc20_tokens_t *token = (const erc20_tokens_t *)PIC(&supportedTokens[i]);
+        if (MEMCMP(ethTxObj->tx.to.ptr, token->address, ETH_ADDRESS_LEN) == 0) {
+            return printEvmNumber(ethTxObj->tx.data.ptr + ERC20_AMOUNT_OFFSET, ERC20_AMOUNT_LEN, token->decimals,
+                                  token->symbol, outVal, outValLen, pageIdx, pageCount);
+        }
     }
+    return parser_unexpected_value;
+}
 
-    return parser_ok;
+// Items of an EVM review. The shared EVM parser owns the tx and has no hook when parsing ends,
+// so the display plan is compiled on the first query and kept next to the parsed tx.
+typedef enum {
+    evm_receiver,
+    evm_contract,
+    evm_to,
+    evm_coin_asset,
+    evm_token_amount,
+    evm_value,      // in FLR
+    evm_raw_value,  // in wei, shown by ERC20 transfers
+    evm_data,
+    evm_nonce,
+    evm_max_priority_fee,
+    evm_max_fee,
+    evm_gas_price,
+    evm_gas_limit,
+    evm_hash,
+} evm_display_kind_e;
+
+#define EVM_PLAN_MAX_ITEMS 11
+
+// The plan only depends on these facts of the tx, so it is reused while they stay the same
+#define EVM_PLAN_COMPILED 0x01u
+#define EVM_PLAN_ERC20 0x02u
+#define EVM_PLAN_FEE_MARKET 0x04u
+#define EVM_PLAN_HAS_TO 0x08u
+#define EVM_PLAN_HAS_DATA 0x10u
+
+typedef struct {
+    uint8_t key;  // EVM_PLAN_* facts the plan was compiled from, 0 before the first compile
+    uint8_t n_items;
+    uint8_t kind[EVM_PLAN_MAX_ITEMS];
+} evm_plan_t;
+
+static evm_plan_t evm_plan;
+
+static void evm_plan_push(evm_plan_t *plan, evm_display_kind_e kind) { plan->kind[plan->n_items++] = (uint8_t)kind; }
+
+static uint8_t evm_plan_key(const eth_tx_t *ethTxObj, bool erc20) {
+    uint8_t key = EVM_PLAN_COMPILED;
+    key |= erc20 ? EVM_PLAN_ERC20 : 0;
+    key |= (ethTxObj->tx_type == eip1559) ? EVM_PLAN_FEE_MARKET : 0;
+    key |= (ethTxObj->tx.to.rlpLen != 0) ? EVM_PLAN_HAS_TO : 0;
+    key |= (ethTxObj->tx.data.rlpLen != 0) ? EVM_PLAN_HAS_DATA : 0;
+    return key;
 }
 
-parser_error_t getNumItemsEthAppSpecific(eth_tx_t *ethTxObj, uint8_t *numItems) {
-    if (numItems == NULL || ethTxObj == NULL) {
-        return parser_unexpected_error;
-    }
-    // Verify that tx is ERC20
-    if (validateERC20(ethTxObj)) {
-        if (ethTxObj->tx_type == legacy || ethTxObj->tx_type == eip2930) {
-            *numItems = 10;
+static void evm_plan_compile(uint8_t key, evm_plan_t *plan) {
+    plan->n_items = 0;
+    plan->key = key;
+    const bool fee_market = (key & EVM_PLAN_FEE_MARKET) != 0;
+
+    if ((key & EVM_PLAN_ERC20) != 0) {
+        evm_plan_push(plan, evm_receiver);
+        evm_plan_push(plan, evm_contract);
+        evm_plan_push(plan, evm_coin_asset);
+        evm_plan_push(plan, evm_token_amount);
+        evm_plan_push(plan, evm_nonce);
+        if (fee_market) {
+            evm_plan_push(plan, evm_max_priority_fee);
+            evm_plan_push(plan, evm_max_fee);
         } else {
-            *numItems = 11;
+            evm_plan_push(plan, evm_gas_price);
         }
-        return parser_ok;
+        evm_plan_push(plan, evm_gas_limit);
+        evm_plan_push(plan, evm_raw_value);
+        evm_plan_push(plan, evm_data);
+        evm_plan_push(plan, evm_hash);
+        return;
     }
 
-    if (ethTxObj->tx_type == legacy || ethTxObj->tx_type == eip2930) {
-        *numItems = 6;
-    } else {
-        *numItems = 7;
+    // Contract creations have no recipient, plain transfers no data
+    if ((key & EVM_PLAN_HAS_TO) != 0) {
+        evm_plan_push(plan, evm_to);
     }
-
-    *numItems += ((ethTxObj->tx.data.rlpLen != 0) ? 1 : 0) + ((ethTxObj->tx.to.rlpLen != 0) ? 1 : 0);
-
-    return parser_ok;
-}
-
-parser_error_t printGenericAppSpecific(const parser_context_t *ctx, const eth_tx_t *ethTxObj, uint8_t displayIdx,
-                                       char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen, uint8_t pageIdx,
-                                       uint8_t *pageCount) {
-    if (ctx == NULL || ethTxObj == NULL) {
-        return parser_unexpected_error;
+    evm_plan_push(plan, evm_coin_asset);
+    evm_plan_push(plan, evm_value);
+    if ((key & EVM_PLAN_HAS_DATA) != 0) {
+        evm_plan_push(plan, evm_data);
     }
-
-    char data_array[TMP_DATA_ARRAY_SIZE] = {0};
-
-    if ((displayIdx >= 3 && ethTxObj->tx.data.rlpLen == 0) || ethTxObj->tx.to.rlpLen == 0) {
-        displayIdx += 1;
+    if (fee_market) {
+        evm_plan_push(plan, evm_max_priority_fee);
+        evm_plan_push(plan, evm_max_fee);
+        evm_plan_push(plan, evm_gas_limit);
+    } else {
+        evm_plan_push(plan, evm_gas_limit);
+        evm_plan_push(plan, evm_gas_price);
     }
+    evm_plan_push(plan, evm_nonce);
+    evm_plan_push(plan, evm_hash);
+}
 
-    if (ethTxObj->tx_type == eip1559 && displayIdx >= 7) {
-        displayIdx++;
+// Plan of ethTxObj, compiled again only when the tx it was compiled for differs in shape
+static const evm_plan_t *evm_plan_get(const eth_tx_t *ethTxObj, bool erc20) {
+    const uint8_t key = evm_plan_key(ethTxObj, erc20);
+    if (evm_plan.key != key) {
+        evm_plan_compile(key, &evm_plan);
     }
+    return &evm_plan;
+}
 
-    if ((ethTxObj->tx_type == legacy || ethTxObj->tx_type == eip2930) && displayIdx >= 4) {
-        displayIdx += 2;
+static parser_error_t printEvmItem(const parser_context_t *ctx, const eth_tx_t *ethTxObj, bool erc20, uint8_t displayIdx,
+                                   char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen, uint8_t pageIdx,
+                                   uint8_t *pageCount) {
+    const evm_plan_t *plan = evm_plan_get(ethTxObj, erc20);
+    if (displayIdx >= plan->n_items) {
+        return parser_display_page_out_of_range;
     }
 
-    switch (displayIdx) {
-        case 0:
-            snprintf(outKey, outKeyLen, "To");
+    switch (plan->kind[displayIdx]) {
+        case evm_receiver: {
+            write_str(outKey, outKeyLen, "Receiver");
+            rlp_t to = {
+                .kind = RLP_KIND_STRING, .ptr = (ethTxObj->tx.data.ptr + ERC20_TRANSFER_OFFSET), .rlpLen = ETH_ADDRESS_LEN};
+            return printEVMAddress(&to, outVal, outValLen, pageIdx, pageCount);
+        }
+        case evm_contract:
+        case evm_to: {
+            write_str(outKey, outKeyLen, plan->kind[displayIdx] == evm_contract ? "Contract" : "To");
             rlp_t contractAddress = {.kind = RLP_KIND_STRING, .ptr = ethTxObj->tx.to.ptr, .rlpLen = ETH_ADDRESS_LEN};
-            CHECK_ERROR(printEVMAddress(&contractAddress, outVal, outValLen, pageIdx, pageCount));
-            break;
-        case 1:
-            snprintf(outKey, outKeyLen, "Coin asset");
-            CHECK_ERROR(getNetworkName(ethTxObj->chainId.chain_id_decoded, outVal, outValLen));
-            break;
-        case 2:
-            snprintf(outKey, outKeyLen, "Value");
-            printBigIntFixedPoint(ethTxObj->tx.value.ptr, ethTxObj->tx.value.rlpLen, outVal, outValLen, pageIdx, pageCount,
-                                  COIN_AMOUNT_DECIMAL);
-            break;
-
-        case 3:
-            snprintf(outKey, outKeyLen, "Data");
-            array_to_hexstr(data_array, sizeof(data_array), ethTxObj->tx.data.ptr,
-                            ethTxObj->tx.data.rlpLen > DATA_BYTES_TO_PRINT ? DATA_BYTES_TO_PRINT : ethTxObj->tx.data.rlpLen);
-
-            if (ethTxObj->tx.data.rlpLen > DATA_BYTES_TO_PRINT) {
-                snprintf(data_array + (2 * DATA_BYTES_TO_PRINT), 4, "...");
-            }
-
-            pageString(outVal, outValLen, data_array, pageIdx, pageCount);
-            break;
-
-        case 4:
-            snprintf(outKey, outKeyLen, "Max Priority Fee");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.max_priority_fee_per_gas, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 5:
-            snprintf(outKey, outKeyLen, "Max Fee");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.max_fee_per_gas, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 6:
-            snprintf(outKey, outKeyLen, "Gas limit");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.gasLimit, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 7:
-            snprintf(outKey, outKeyLen, "Gas price");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.gasPrice, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 8:
-            snprintf(outKey, outKeyLen, "Nonce");
-            CHECK_ERROR(printRLPNumber(&ethTxObj->tx.nonce, outVal, outValLen, pageIdx, pageCount));
-            break;
-
-        case 9:
-            CHECK_ERROR(printEthHash(ctx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount));
-            break;
-
+            return printEVMAddress(&contractAddress, outVal, outValLen, pageIdx, pageCount);
+        }
+        case evm_coin_asset:
+            write_str(outKey, outKeyLen, "Coin asset");
+            return getNetworkName(ethTxObj->chainId.chain_id_decoded, outVal, outValLen);
+        case evm_token_amount:
+            write_str(outKey, outKeyLen, "Amount");
+            return printERC20ValueAppSpecific(ethTxObj, outVal, outValLen, pageIdx, pageCount);
+        case evm_value:
+            write_str(outKey, outKeyLen, "Value");
+            return printEvmNumber(ethTxObj->tx.value.ptr, ethTxObj->tx.value.rlpLen, COIN_AMOUNT_DECIMAL, NULL, outVal,
+                                  outValLen, pageIdx, pageCount);
+        case evm_raw_value:
+            write_str(outKey, outKeyLen, "Value");
+            return printRLPNumberAppSpecific(&ethTxObj->tx.value, outVal, outValLen, pageIdx, pageCount);
+        case evm_data:
+            write_str(outKey, outKeyLen, "Data");
+            return printData(&ethTxObj->tx.data, outVal, outValLen, pageIdx, pageCount);
+        case evm_nonce:
+            write_str(outKey, outKeyLen, "Nonce");
+            return printRLPNumberAppSpecific(&ethTxObj->tx.nonce, outVal, outValLen, pageIdx, pageCount);
+        case evm_max_priority_fee:
+            write_str(outKey, outKeyLen, "Max Priority Fee");
+            return printRLPNumberAppSpecific(&ethTxObj->tx.max_priority_fee_per_gas, outVal, outValLen, pageIdx,
+                                             pageCount);
+        case evm_max_fee:
+            write_str(outKey, outKeyLen, "Max Fee");
+            return printRLPNumberAppSpecific(&ethTxObj->tx.max_fee_per_gas, outVal, outValLen, pageIdx, pageCount);
+        case evm_gas_price:
+            write_str(outKey, outKeyLen, "Gas price");
+            return printRLPNumberAppSpecific(&ethTxObj->tx.gasPrice, outVal, outValLen, pageIdx, pageCount);
+        case evm_gas_limit:
+            write_str(outKey, outKeyLen, "Gas limit");
+            return printRLPNumberAppSpecific(&ethTxObj->tx.gasLimit, outVal, outValLen, pageIdx, pageCount);
+        case evm_hash:
+            return printEthHashAppSpecific(ctx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
         default:
             return parser_display_page_out_of_range;
     }
+}
 
+parser_error_t printERC20TransferAppSpecific(const parser_context_t *ctx, const eth_tx_t *ethTxObj, uint8_t displayIdx,
+                                             char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen,
+                                             uint8_t pageIdx, uint8_t *pageCount) {
+    if (ctx == NULL || ethTxObj == NULL || outKey == NULL || outVal == NULL || pageCount == NULL) {
+        return parser_unexpected_error;
+    }
+    return printEvmItem(ctx, ethTxObj, true, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+}
+
+parser_error_t getNumItemsEthAppSpecific(eth_tx_t *ethTxObj, uint8_t *numItems) {
+    if (numItems == NULL || ethTxObj == NULL) {
+        return parser_unexpected_error;
+    }
+    *numItems = evm_plan_get(ethTxObj, validateERC20(ethTxObj))->n_items;
     return parser_ok;
 }
+
+parser_error_t printGenericAppSpecific(const parser_context_t *ctx, const eth_tx_t *ethTxObj, uint8_t displayIdx,
+                                       char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen, uint8_t pageIdx,
+                                       uint8_t *pageCount) {
+    if (ctx == NULL || ethTxObj == NULL) {
+        return parser_unexpected_error;
+    }
+    return printEvmItem(ctx, ethTxObj, false, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+}
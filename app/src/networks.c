@@ -0,0 +1,110 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "networks.h"
+
+#include "zxmacros.h"
+
+static const network_info_t networks[] = {
+    [mainnet] = {MAINNET_ID,
+                 FLARE_MAINNET_CHAINID,
+                 "flare",
+                 0x02673bff,
+                 "FLR",
+                 "Flare",
+                 {0x77, 0xd3, 0x07, 0x4d, 0xc5, 0x10, 0xf4, 0x3b, 0x09, 0xac, 0x5b, 0xe7, 0x7e, 0xde, 0xe2, 0x76,
+                  0xef, 0x3b, 0x55, 0xf0, 0x09, 0x7d, 0x50, 0x48, 0x46, 0xaa, 0x8e, 0xec, 0x61, 0x3f, 0xc6, 0x25}},
+    [songbird] = {SONGBIRD_ID,
+                  SONG_BIRD_CHAINID,
+                  "song",
+                  0x177d529e,
+                  "SGB",
+                  "Songbird",
+                  {0x55, 0xf0, 0x77, 0xed, 0x33, 0x88, 0x89, 0x8d, 0x7c, 0x52, 0xc1, 0xa1, 0x0c, 0xae, 0x70, 0xe8,
+                   0x34, 0x50, 0xc3, 0x34, 0x99, 0xf4, 0xeb, 0x1a, 0xe8, 0x18, 0x77, 0xb6, 0xf8, 0xfd, 0xa4, 0x02}},
+    [coston] = {COSTON_ID,
+                COSTON_CHAINID,
+                "coston",
+                0x3f304f22,
+                "CFLR",
+                "Coston Flare",
+                {0xff, 0xb1, 0x19, 0xb4, 0x04, 0xc1, 0x35, 0x6b, 0x6b, 0xfd, 0xb8, 0x00, 0x45, 0xe2, 0x7b, 0xa1,
+                 0x3c, 0x37, 0x89, 0xb5, 0xb3, 0x68, 0x4f, 0x00, 0x1d, 0xa0, 0x71, 0xcd, 0x4e, 0x6d, 0xb0, 0x9c}},
+    [coston2] = {COSTON2_ID,
+                 COSTON2_CHAINID,
+                 "costwo",
+                 0x3f304c23,
+                 "C2FLR",
+                 "Coston2 Flare",
+                 {0x78, 0xdb, 0x5c, 0x30, 0xbe, 0xd0, 0x4c, 0x05, 0xce, 0x20, 0x91, 0x79, 0x81, 0x28, 0x50, 0xbb,
+                  0xb3, 0xfe, 0x6d, 0x46, 0xd7, 0xee, 0xf3, 0x74, 0x4d, 0x81, 0x4c, 0x0d, 0xa5, 0x55, 0x24, 0x79}},
+};
+
+const network_info_t *network_get(network_id_e network) {
+    if ((uint32_t)network >= array_length(networks)) {
+        return NULL;
+    }
+    return (const network_info_t *)PIC(&networks[network]);
+}
+
+parser_error_t network_from_id(uint32_t network_id, network_id_e *network) {
+    for (uint8_t i = 0; i < array_length(networks); i++) {
+        if (networks[i].network_id == network_id) {
+            *network = (network_id_e)i;
+            return parser_ok;
+        }
+    }
+    return parser_unexpected_network;
+}
+
+parser_error_t network_from_evm_chain_id(uint64_t evm_chain_id, network_id_e *network) {
+    for (uint8_t i = 0; i < array_length(networks); i++) {
+        if (networks[i].evm_chain_id == evm_chain_id) {
+            *network = (network_id_e)i;
+            return parser_ok;
+        }
+    }
+    return parser_invalid_chain_id;
+}
+
+parser_error_t network_chain_lookup(network_id_e network, const uint8_t *blockchain_id, chain_id_e *chain, char *alias) {
+    const network_info_t *info = network_get(network);
+    if (info == NULL || blockchain_id == NULL) {
+        return parser_unexpected_chain;
+    }
+
+    // The P-chain id is all zeros on every network; the first word tells both candidates apart
+    uint32_t first_word = 0;
+    MEMCPY(&first_word, blockchain_id, sizeof(first_word));
+
+    if (first_word == 0) {
+        for (uint8_t i = sizeof(first_word); i < BLOCKCHAIN_ID_LEN; i++) {
+            if (blockchain_id[i] != 0) {
+                return parser_unexpected_chain;
+            }
+        }
+        *chain = p_chain;
+        *alias = 'P';
+        return parser_ok;
+    }
+
+    if (MEMCMP(info->c_chain_id, blockchain_id, BLOCKCHAIN_ID_LEN) == 0) {
+        *chain = c_chain;
+        *alias = 'C';
+        return parser_ok;
+    }
+
+    return parser_unexpected_chain;
+}
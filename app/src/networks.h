@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include "parser_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// EVM chain ids of the supported networks
+#define FLARE_MAINNET_CHAINID 14
+#define COSTON_CHAINID 16
+#define SONG_BIRD_CHAINID 19
+#define COSTON2_CHAINID 114
+
+#define NETWORK_HRP_LEN 8
+#define NETWORK_TICKER_LEN 8
+#define NETWORK_NAME_LEN 16
+
+// Everything the app knows about a network, indexed by network_id_e.
+// Strings are stored inline so entries need no PIC fixups.
+typedef struct {
+    uint32_t network_id;
+    uint64_t evm_chain_id;
+    char hrp[NETWORK_HRP_LEN];
+    uint32_t hrp_state;  // bech32 checksum state after the expanded hrp
+    char ticker[NETWORK_TICKER_LEN];
+    char name[NETWORK_NAME_LEN];
+    uint8_t c_chain_id[BLOCKCHAIN_ID_LEN];
+} network_info_t;
+
+// Entry of a parsed network, NULL if unknown
+const network_info_t *network_get(network_id_e network);
+
+parser_error_t network_from_id(uint32_t network_id, network_id_e *network);
+parser_error_t network_from_evm_chain_id(uint64_t evm_chain_id, network_id_e *network);
+
+// Resolves a blockchain id of the given network to its chain and one letter alias
+parser_error_t network_chain_lookup(network_id_e network, const uint8_t *blockchain_id, chain_id_e *chain, char *alias);
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,7 +17,6 @@
 #include "parser.h"
 
 #include <bech32.h>
-#include <stdio.h>
 #include <zxformat.h>
 #include <zxmacros.h>
 #include <zxtypes.h>
@@ -27,10 +26,54 @@
 #include "coin.h"
 #include "crypto.h"
 #include "crypto_helper.h"
+#include "parser_display.h"
 #include "parser_impl_common.h"
+#include "parser_print_common.h"
 #include "tx_cchain.h"
 #include "tx_pchain.h"
 
+// Rendered values are kept in a small direct-mapped cache keyed by display index so that paging
+// through an item slices the stored string instead of rendering it again. Targets can override
+// the budget; NanoX (ZXLIB_LIGHT_MODE) keeps it small, within the RAM the compact parser_tx_t gave back.
+#ifndef PARSER_ITEM_CACHE_SLOTS
+#if defined(ZXLIB_LIGHT_MODE)
+#define PARSER_ITEM_CACHE_SLOTS 8
+#else
+#define PARSER_ITEM_CACHE_SLOTS 16
+#endif
+#endif
+
+#ifndef PARSER_ITEM_CACHE_KEY_LEN
+#define PARSER_ITEM_CACHE_KEY_LEN 24
+#endif
+
+#ifndef PARSER_ITEM_CACHE_VALUE_LEN
+#define PARSER_ITEM_CACHE_VALUE_LEN 64
+#endif
+
+typedef struct {
+    bool used;
+    uint8_t displayIdx;
+    char key[PARSER_ITEM_CACHE_KEY_LEN];
+    char value[PARSER_ITEM_CACHE_VALUE_LEN];
+} parser_item_cache_entry_t;
+
+typedef struct {
+    const parser_tx_t *tx_obj;
+    bool expert;
+    parser_item_cache_entry_t entries[PARSER_ITEM_CACHE_SLOTS];
+} parser_item_cache_t;
+
+static parser_item_cache_t item_cache;
+
+_Static_assert(sizeof(parser_tx_t) <= PARSER_TX_MAX_SIZE, "parser_tx_t outgrew its RAM budget");
+
+static void parser_item_cache_reset(const parser_tx_t *tx_obj) {
+    MEMZERO(&item_cache, sizeof(item_cache));
+    item_cache.tx_obj = tx_obj;
+    item_cache.expert = app_mode_expert();
+}
+
 parser_error_t parser_init_context(parser_context_t *ctx, const uint8_t *buffer, uint16_t bufferSize) {
     ctx->offset = 0;
     ctx->buffer = NULL;
@@ -50,22 +93,45 @@ parser_error_t parser_parse(parser_context_t *ctx, const uint8_t *data, size_t d
     CHECK_ERROR(parser_init_context(ctx, data, dataLen))
     ctx->tx_obj = tx_obj;
     app_mode_skip_blindsign_ui();
+    parser_item_cache_reset(tx_obj);
     return _read(ctx, tx_obj);
 }
 
+parser_error_t parser_parse_chunk(parser_context_t *ctx, const uint8_t *data, size_t dataLen, parser_tx_t *tx_obj,
+                                  bool last) {
+    CHECK_ERROR(parser_init_context(ctx, data, dataLen))
+    ctx->tx_obj = tx_obj;
+    app_mode_skip_blindsign_ui();
+    parser_item_cache_reset(tx_obj);
+    return _read_chunk(ctx, tx_obj, last);
+}
+
+parser_error_t parser_set_change_address(const uint8_t *address, uint16_t addressLen) {
+    return _set_change_address(address, addressLen);
+}
+
+parser_error_t parser_set_tx_hash(parser_context_t *ctx, const uint8_t *hash, uint16_t hashLen) {
+    if (ctx == NULL || ctx->tx_obj == NULL || hash == NULL || hashLen != sizeof(ctx->tx_obj->tx_hash)) {
+        return parser_unexpected_error;
+    }
+    MEMCPY(ctx->tx_obj->tx_hash, hash, hashLen);
+    ctx->tx_obj->tx_hash_ready = true;
+    return parser_ok;
+}
+
 parser_error_t parser_validate(parser_context_t *ctx) {
-    // Iterate through all items to check that all can be shown and are valid
+    if (ctx == NULL || ctx->tx_obj == NULL) {
+        return parser_no_data;
+    }
+
+    // Check that all items can be shown and are valid, without rendering them
     uint8_t numItems = 0;
     CHECK_ERROR(parser_getNumItems(ctx, &numItems))
 
-    char tmpKey[40] = {0};
-    char tmpVal[40] = {0};
-
-    for (uint8_t idx = 0; idx < numItems; idx++) {
-        uint8_t pageCount = 0;
-        CHECK_ERROR(parser_getItem(ctx, idx, tmpKey, sizeof(tmpKey), tmpVal, sizeof(tmpVal), 0, &pageCount))
+    if (ctx->tx_obj->chain_id == c_chain) {
+        return parser_validate_cchain(ctx);
     }
-    return parser_ok;
+    return parser_validate_pchain(ctx);
 }
 
 parser_error_t parser_getNumItems(const parser_context_t *ctx, uint8_t *num_items) {
@@ -78,10 +144,8 @@ parser_error_t cleanOutput(char *outKey, uint16_t outKeyLen, char *outVal, uint1
         return parser_no_data;
     };
 
-    MEMZERO(outKey, outKeyLen);
-    MEMZERO(outVal, outValLen);
-    snprintf(outKey, outKeyLen, "?");
-    snprintf(outVal, outValLen, " ");
+    write_str(outKey, outKeyLen, "?");
+    write_str(outVal, outValLen, " ");
 
     return parser_ok;
 }
@@ -104,29 +168,114 @@ parser_error_t _getItemFlr(const parser_context_t *ctx, uint8_t displayIdx, char
     CHECK_ERROR(checkSanity(numItems, displayIdx))
     CHECK_ERROR(cleanOutput(outKey, outKeyLen, outVal, outValLen));
 
-    switch (ctx->tx_obj->tx_type) {
-        case base_tx:
-            return print_base_tx(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
-        case p_export_tx:
-            return print_p_export_tx(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
-        case p_import_tx:
-            return print_p_import_tx(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
-        case c_export_tx:
-            return print_c_export_tx(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
-        case c_import_tx:
-            return print_c_import_tx(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
-        case add_permissionless_delegator_tx:
-        case add_permissionless_validator_tx:
-            return print_add_permissionless_del_val_tx(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx,
-                                                       pageCount);
-        default:
-            break;
+    return parser_display_item(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+}
+
+// Values without a known length are rendered into this much space to be measured
+#define PAGE_COUNT_SCRATCH_LEN 64
+
+// Pages pageString splits len characters into
+static uint8_t string_page_count(uint16_t len, uint16_t outValLen) {
+    if (outValLen <= 1) {
+        return 0;
+    }
+    return (uint8_t)(((uint32_t)len + outValLen - 2) / (outValLen - 1));
+}
+
+parser_error_t parser_getItemPageCount(const parser_context_t *ctx, uint8_t displayIdx, uint16_t outValLen,
+                                       uint8_t *pageCount) {
+    if (ctx == NULL || ctx->tx_obj == NULL || pageCount == NULL || outValLen == 0) {
+        return parser_no_data;
     }
+    *pageCount = 0;
+
+    uint8_t numItems = 0;
+    CHECK_ERROR(parser_getNumItems(ctx, &numItems))
+    CHECK_ERROR(checkSanity(numItems, displayIdx))
 
-    return parser_display_idx_out_of_range;
+    display_kind_e kind = display_hash;
+    uint8_t itemIdx = 0;
+    CHECK_ERROR(parser_display_lookup(ctx->tx_obj, displayIdx, &kind, &itemIdx))
+
+    // The hash is paged as hex, two characters per byte
+    if (kind == display_hash) {
+        const uint16_t bytesPerPage = (outValLen - 1) / 2;
+        if (bytesPerPage > 0) {
+            *pageCount = (uint8_t)((TX_HASH_LEN + bytesPerPage - 1) / bytesPerPage);
+        }
+        return parser_ok;
+    }
+
+    uint16_t len = 0;
+    const parser_error_t err = getItemValueLen(ctx, displayIdx, &len);
+    if (err == parser_ok) {
+        *pageCount = string_page_count(len, outValLen);
+        return parser_ok;
+    }
+    if (err != parser_no_data) {
+        return err;
+    }
+
+    // Variable length value: render it, at most PAGE_COUNT_SCRATCH_LEN at a time
+    char key[2];
+    char scratch[PAGE_COUNT_SCRATCH_LEN];
+    const uint16_t scratchLen = (outValLen < sizeof(scratch)) ? outValLen : sizeof(scratch);
+    uint8_t scratchPages = 0;
+    CHECK_ERROR(parser_getItem(ctx, displayIdx, key, sizeof(key), scratch, scratchLen, 0, &scratchPages))
+    if (scratchLen == outValLen || scratchPages <= 1) {
+        // Measured at the requested width, or short enough for a single page of it
+        *pageCount = scratchPages;
+        return parser_ok;
+    }
+
+    // Only paged values take more than one scratch page; the last one gives the exact length
+    CHECK_ERROR(parser_getItem(ctx, displayIdx, key, sizeof(key), scratch, scratchLen, scratchPages - 1, &scratchPages))
+    len = (uint16_t)((scratchPages - 1) * (scratchLen - 1) + strlen(scratch));
+    *pageCount = string_page_count(len, outValLen);
+    return parser_ok;
 }
 
 parser_error_t parser_getItem(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
                               char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    return _getItemFlr(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+    if (ctx == NULL || ctx->tx_obj == NULL || pageCount == NULL) {
+        return parser_no_data;
+    }
+    *pageCount = 0;
+
+    uint8_t numItems = 0;
+    CHECK_ERROR(parser_getNumItems(ctx, &numItems))
+    CHECK_ERROR(checkSanity(numItems, displayIdx))
+    CHECK_ERROR(cleanOutput(outKey, outKeyLen, outVal, outValLen))
+
+    // The hash is paged as hex from the stored digest, which is already cheap, so it is not cached
+    display_kind_e kind = display_hash;
+    uint8_t itemIdx = 0;
+    CHECK_ERROR(parser_display_lookup(ctx->tx_obj, displayIdx, &kind, &itemIdx))
+    if (kind == display_hash) {
+        return _getItemFlr(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+    }
+
+    const bool expert = app_mode_expert();
+
+    if (item_cache.tx_obj != ctx->tx_obj || item_cache.expert != expert) {
+        parser_item_cache_reset(ctx->tx_obj);
+    }
+
+    parser_item_cache_entry_t *entry = &item_cache.entries[displayIdx % PARSER_ITEM_CACHE_SLOTS];
+    if (!entry->used || entry->displayIdx != displayIdx) {
+        entry->used = false;
+        uint8_t fullPageCount = 0;
+        CHECK_ERROR(_getItemFlr(ctx, displayIdx, entry->key, sizeof(entry->key), entry->value, sizeof(entry->value), 0,
+                                &fullPageCount))
+        if (fullPageCount != 1) {
+            // Does not fit in the cache, render the requested page directly
+            return _getItemFlr(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+        }
+        entry->displayIdx = displayIdx;
+        entry->used = true;
+    }
+
+    write_str(outKey, outKeyLen, entry->key);
+    pageString(outVal, outValLen, entry->value, pageIdx, pageCount);
+    return parser_ok;
 }
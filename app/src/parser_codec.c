@@ -0,0 +1,117 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "parser_codec.h"
+
+#include "zxmacros.h"
+
+// Verify the asset ID at offset matches every previously parsed asset ID on this
+// transaction. The first asset ID seen is captured as the expected one; any later mismatch
+// is rejected. Flare's P-chain staking/import/export and C-chain atomic flows are
+// native-asset-only, so every asset ID in a valid tx must be identical.
+static parser_error_t codec_check_asset_id(const parser_context_t *c, uint16_t offset) {
+    if (c->tx_obj == NULL) {
+        return parser_ok;
+    }
+    const uint8_t *expected = parser_tx_field(c, c->tx_obj->expected_asset_id);
+    if (expected == NULL) {
+        c->tx_obj->expected_asset_id = offset;
+    } else if (MEMCMP(expected, c->buffer + offset, ASSET_ID_LEN) != 0) {
+        return parser_unexpected_network;
+    }
+    return parser_ok;
+}
+
+// Bytes taken by fields [first, *end), where *end stops right after the next array count
+static uint32_t codec_run_len(const codec_schema_t *schema, uint8_t first, uint8_t *end) {
+    uint32_t len = 0;
+    uint8_t i = first;
+    while (i < schema->n_fields) {
+        const codec_field_t *field = &schema->fields[i++];
+        if (field->type == codec_array) {
+            len += sizeof(uint32_t);
+            break;
+        }
+        len += field->len;
+    }
+    *end = i;
+    return len;
+}
+
+parser_error_t codec_decode(parser_context_t *c, const codec_schema_t *schema, codec_record_t *record) {
+    if (c == NULL || c->buffer == NULL || schema == NULL || record == NULL) {
+        return parser_unexpected_error;
+    }
+
+    uint8_t i = 0;
+    while (i < schema->n_fields) {
+        uint8_t end = 0;
+        if ((uint32_t)c->offset + codec_run_len(schema, i, &end) > c->bufferLen) {
+            return parser_unexpected_buffer_end;
+        }
+
+        // Every field up to end is in the buffer
+        for (; i < end; i++) {
+            const codec_field_t *field = &schema->fields[i];
+            const uint8_t *p = c->buffer + c->offset;
+            uint16_t offset = c->offset;
+            uint64_t value = 0;
+
+            switch (field->type) {
+                case codec_u32:
+                    value = codec_read_be32(p);
+                    break;
+                case codec_u64:
+                    value = codec_read_be64(p);
+                    break;
+                case codec_type_id:
+                    if (codec_read_be32(p) != field->arg) {
+                        return parser_unexpected_type_id;
+                    }
+                    break;
+                case codec_asset_id:
+                    CHECK_ERROR(codec_check_asset_id(c, offset))
+                    break;
+                case codec_array: {
+                    value = codec_read_be32(p);
+                    if (value > field->arg) {
+                        return parser_unexpected_number_items;
+                    }
+                    offset = c->offset + sizeof(uint32_t);
+                    const uint32_t elements_len = (uint32_t)value * field->len;
+                    if ((uint32_t)offset + elements_len > c->bufferLen) {
+                        return parser_unexpected_buffer_end;
+                    }
+                    c->offset = (uint16_t)(offset + elements_len);
+                    break;
+                }
+                case codec_bytes:
+                    break;
+                default:
+                    return parser_unexpected_error;
+            }
+
+            if (field->type != codec_array) {
+                c->offset += field->len;
+            }
+            if (field->slot < CODEC_MAX_SLOTS) {
+                record->value[field->slot] = value;
+                record->offset[field->slot] = offset;
+            }
+        }
+    }
+
+    return parser_ok;
+}
@@ -0,0 +1,96 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include "parser_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Avalanche codec records are described once as a list of fields. Runs of fixed-size fields are
+// bounds checked with a single comparison, a variable-length array ends its run and is checked
+// as a whole once its count is known.
+typedef enum {
+    codec_bytes,     // len bytes, only its offset is kept
+    codec_u32,       // big-endian uint32
+    codec_u64,       // big-endian uint64
+    codec_type_id,   // big-endian uint32 that must equal arg
+    codec_asset_id,  // asset ID that must match the tx-wide native asset
+    codec_array,     // uint32 count, at most arg elements of len bytes
+} codec_field_type_e;
+
+// Field slots of a decoded record
+#define CODEC_MAX_SLOTS 6
+#define CODEC_NO_SLOT 0xFF
+
+typedef struct {
+    uint8_t type;
+    uint8_t len;
+    uint8_t slot;
+    uint32_t arg;
+} codec_field_t;
+
+typedef struct {
+    const codec_field_t *fields;
+    uint8_t n_fields;
+} codec_schema_t;
+
+// value holds integers and array counts, offset where each field (or the first array element) starts
+typedef struct {
+    uint64_t value[CODEC_MAX_SLOTS];
+    uint16_t offset[CODEC_MAX_SLOTS];
+} codec_record_t;
+
+#define CODEC_BYTES(LEN, SLOT) {codec_bytes, (LEN), (SLOT), 0}
+#define CODEC_SKIP(LEN) {codec_bytes, (LEN), CODEC_NO_SLOT, 0}
+#define CODEC_U32(SLOT) {codec_u32, sizeof(uint32_t), (SLOT), 0}
+#define CODEC_U64(SLOT) {codec_u64, sizeof(uint64_t), (SLOT), 0}
+#define CODEC_TYPE_ID(TYPE_ID) {codec_type_id, sizeof(uint32_t), CODEC_NO_SLOT, (TYPE_ID)}
+#define CODEC_ASSET_ID() {codec_asset_id, ASSET_ID_LEN, CODEC_NO_SLOT, 0}
+#define CODEC_ARRAY(ELEMENT_LEN, MAX_COUNT, SLOT) {codec_array, (ELEMENT_LEN), (SLOT), (MAX_COUNT)}
+
+#define CODEC_SCHEMA(FIELDS) {(FIELDS), (uint8_t)(sizeof(FIELDS) / sizeof((FIELDS)[0]))}
+
+// Decodes one record at the current offset and advances past it
+parser_error_t codec_decode(parser_context_t *c, const codec_schema_t *schema, codec_record_t *record);
+
+// Big-endian loads from an unaligned pointer. Callers check the bounds.
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "codec loads assume a little-endian target"
+#endif
+
+static inline uint16_t codec_read_be16(const uint8_t *p) {
+    uint16_t v = 0;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return __builtin_bswap16(v);
+}
+
+static inline uint32_t codec_read_be32(const uint8_t *p) {
+    uint32_t v = 0;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return __builtin_bswap32(v);
+}
+
+static inline uint64_t codec_read_be64(const uint8_t *p) {
+    uint64_t v = 0;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return __builtin_bswap64(v);
+}
+
+#ifdef __cplusplus
+}
+#endif
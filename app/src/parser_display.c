@@ -0,0 +1,350 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "parser_display.h"
+
+#include "app_mode.h"
+#include "parser_impl_common.h"
+#include "parser_print_common.h"
+#include "zxformat.h"
+#include "zxmacros.h"
+
+// Review of each tx type. Adding a tx type only takes a new list here.
+static const uint8_t plan_base_tx[] = {display_send,           display_output_groups, display_outputs,
+                                       display_change_outputs, display_fee,           display_hash};
+static const uint8_t plan_p_export_tx[] = {display_p_export, display_output_groups, display_outputs, display_fee,
+                                           display_hash};
+static const uint8_t plan_p_import_tx[] = {display_p_import, display_output_groups, display_outputs, display_fee,
+                                           display_hash};
+static const uint8_t plan_c_export_tx[] = {display_c_export, display_output_groups, display_outputs, display_fee,
+                                           display_hash};
+static const uint8_t plan_c_import_tx[] = {display_c_import, display_evm_outputs, display_fee, display_hash};
+static const uint8_t plan_validator_tx[] = {display_node_id,     display_start_time, display_end_time,
+                                            display_total_stake, display_rewards_to, display_delegate_fee,
+                                            display_fee,         display_hash};
+static const uint8_t plan_delegator_tx[] = {display_node_id,    display_start_time, display_end_time, display_total_stake,
+                                            display_rewards_to, display_fee,        display_hash};
+
+// Change and hash are only shown in expert mode. Outputs sharing a destination are summed
+// outside expert mode, which lists them one by one.
+static bool display_shown(const parser_tx_t *v, uint8_t kind, bool expert) {
+    switch (kind) {
+        case display_change_outputs:
+        case display_hash:
+            return expert;
+        case display_output_groups:
+            return !expert;
+        case display_outputs:
+            return expert || v->out_groups.n_groups == 0;
+        default:
+            return true;
+    }
+}
+
+static uint8_t output_items(const output_index_t *index, uint8_t k) {
+    const uint8_t end = (k + 1 < index->n_outputs) ? index->first_item[k + 1] : index->n_items;
+    return end - index->first_item[k];
+}
+
+// Group showing itemIdx of the grouped outputs, and the item of its first output rendered there
+static parser_error_t display_group_item(const parser_tx_t *v, uint8_t itemIdx, uint8_t *group, uint8_t *outputItem) {
+    uint8_t idx = itemIdx;
+    for (uint8_t g = 0; g < v->out_groups.n_groups; g++) {
+        const uint8_t rep = v->out_groups.output[g];
+        const uint8_t items = output_items(&v->out_index, rep);
+        if (idx < items) {
+            *group = g;
+            *outputItem = v->out_index.first_item[rep] + idx;
+            return parser_ok;
+        }
+        idx -= items;
+    }
+    return parser_display_idx_out_of_range;
+}
+
+// Display items kind spans in v
+static uint8_t display_count(const parser_tx_t *v, uint8_t kind) {
+    switch (kind) {
+        case display_outputs:
+            return v->out_index.n_shown_items;
+        case display_output_groups: {
+            uint8_t count = 0;
+            for (uint8_t g = 0; g < v->out_groups.n_groups; g++) {
+                count += output_items(&v->out_index, v->out_groups.output[g]);
+            }
+            return count;
+        }
+        case display_change_outputs:
+            return v->out_index.n_items - v->out_index.n_shown_items;
+        case display_evm_outputs:
+            return v->out_index.n_items;
+        default:
+            return 1;
+    }
+}
+
+#define PLAN_KINDS(PLAN)                    \
+    do {                                    \
+        kinds = (const uint8_t *)PIC(PLAN); \
+        n_kinds = (uint8_t)sizeof(PLAN);    \
+    } while (0)
+
+parser_error_t parser_display_compile(parser_tx_t *v) {
+    if (v == NULL) {
+        return parser_unexpected_error;
+    }
+    MEMZERO(&v->display, sizeof(v->display));
+
+    const uint8_t *kinds = NULL;
+    uint8_t n_kinds = 0;
+    switch (v->tx_type) {
+        case base_tx:
+            PLAN_KINDS(plan_base_tx);
+            break;
+        case p_export_tx:
+            PLAN_KINDS(plan_p_export_tx);
+            break;
+        case p_import_tx:
+            PLAN_KINDS(plan_p_import_tx);
+            break;
+        case c_export_tx:
+            PLAN_KINDS(plan_c_export_tx);
+            break;
+        case c_import_tx:
+            PLAN_KINDS(plan_c_import_tx);
+            break;
+        case add_permissionless_validator_tx:
+            PLAN_KINDS(plan_validator_tx);
+            break;
+        case add_permissionless_delegator_tx:
+            PLAN_KINDS(plan_delegator_tx);
+            break;
+        default:
+            return parser_unexpected_type;
+    }
+
+    uint32_t n_items[DISPLAY_VIEWS] = {0};
+    for (uint8_t i = 0; i < n_kinds; i++) {
+        const uint8_t kind = kinds[i];
+        const uint8_t count = display_count(v, kind);
+        if (count == 0) {
+            continue;
+        }
+        display_entry_t *entry = &v->display.entries[v->display.n_entries];
+        entry->kind = kind;
+        entry->count = count;
+        v->display.n_entries++;
+
+        for (uint8_t view = 0; view < DISPLAY_VIEWS; view++) {
+            if (!display_shown(v, kind, view == DISPLAY_VIEW_EXPERT)) {
+                continue;
+            }
+            if (n_items[view] + count > UINT8_MAX) {
+                MEMZERO(&v->display, sizeof(v->display));
+                return parser_unexpected_number_items;
+            }
+            n_items[view] += count;
+        }
+    }
+
+    for (uint8_t view = 0; view < DISPLAY_VIEWS; view++) {
+        v->display.n_items[view] = (uint8_t)n_items[view];
+    }
+    return parser_ok;
+}
+
+parser_error_t parser_display_num_items(const parser_tx_t *v, uint8_t *numItems) {
+    *numItems = 0;
+    if (v->display.n_items[DISPLAY_VIEW_EXPERT] == 0) {
+        return parser_unexpected_number_items;
+    }
+    *numItems = v->display.n_items[app_mode_expert() ? DISPLAY_VIEW_EXPERT : DISPLAY_VIEW_NORMAL];
+    return parser_ok;
+}
+
+parser_error_t parser_display_lookup(const parser_tx_t *v, uint8_t displayIdx, display_kind_e *kind, uint8_t *itemIdx) {
+    const uint8_t view = app_mode_expert() ? DISPLAY_VIEW_EXPERT : DISPLAY_VIEW_NORMAL;
+    if (displayIdx >= v->display.n_items[view]) {
+        return parser_display_idx_out_of_range;
+    }
+    // At most DISPLAY_PLAN_MAX_ENTRIES entries to walk, each spanning count items of the view
+    uint8_t idx = displayIdx;
+    for (uint8_t i = 0; i < v->display.n_entries; i++) {
+        const display_entry_t *entry = &v->display.entries[i];
+        if (!display_shown(v, entry->kind, view == DISPLAY_VIEW_EXPERT)) {
+            continue;
+        }
+        if (idx < entry->count) {
+            *kind = (display_kind_e)entry->kind;
+            *itemIdx = idx;
+            return parser_ok;
+        }
+        idx -= entry->count;
+    }
+    return parser_display_idx_out_of_range;
+}
+
+parser_error_t parser_display_output_item(const parser_tx_t *v, display_kind_e kind, uint8_t itemIdx, uint8_t *outputItem) {
+    switch (kind) {
+        case display_outputs:
+        case display_evm_outputs:
+            *outputItem = itemIdx;
+            return parser_ok;
+        case display_change_outputs:
+            *outputItem = v->out_index.n_shown_items + itemIdx;
+            return parser_ok;
+        case display_output_groups: {
+            uint8_t group = 0;
+            return display_group_item(v, itemIdx, &group, outputItem);
+        }
+        default:
+            return parser_unexpected_type;
+    }
+}
+
+// "<from> to <alias> chain" and the like, for the item naming the other chain of an atomic tx
+static parser_error_t print_chain(const parser_context_t *ctx, uint16_t chain_offset, const char *key, const char *prefix,
+                                  char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen) {
+    write_str(outKey, outKeyLen, key);
+
+    char chain = 0;
+    CHECK_ERROR(parser_get_chain_alias(ctx->tx_obj->network_id, parser_tx_field(ctx, chain_offset), &chain));
+    writer_t w;
+    writer_init(&w, outVal, outValLen);
+    writer_append_str(&w, prefix);
+    writer_append_char(&w, chain);
+    writer_append_str(&w, " chain");
+    return parser_ok;
+}
+
+// group_amount, when set, replaces the amount of the output with the total of its group
+static parser_error_t print_output_item(const parser_context_t *ctx, uint8_t itemIdx, const uint64_t *group_amount,
+                                        const char *amountKey, bool evm_address, char *outKey, uint16_t outKeyLen,
+                                        char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    uint8_t element_idx = 0;
+    uint64_t amount = 0;
+    uint8_t address[ADDRESS_LEN] = {0};
+
+    CHECK_ERROR(parser_get_output_item(ctx, itemIdx, &amount, address, &element_idx));
+    if (!element_idx) {
+        if (group_amount != NULL) {
+            amount = *group_amount;
+        }
+        write_str(outKey, outKeyLen, amountKey);
+        return printAmount64(amount, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
+                             pageCount);
+    }
+
+    write_str(outKey, outKeyLen, "Address");
+    if (!evm_address) {
+        return printAddress(address, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount);
+    }
+
+    char tmp_buffer[2 + 2 * ADDRESS_LEN + 1] = {0};
+    writer_t w;
+    writer_init(&w, tmp_buffer, sizeof(tmp_buffer));
+    writer_append_str(&w, "0x");
+    writer_append_hex(&w, address, ADDRESS_LEN);
+    pageString(outVal, outValLen, tmp_buffer, pageIdx, pageCount);
+    return parser_ok;
+}
+
+static const validator_t *staking_validator(const parser_tx_t *v) {
+    return (v->tx_type == add_permissionless_validator_tx) ? &v->tx.add_permissionless_validator_tx.validator
+                                                           : &v->tx.add_permissionless_delegator_tx.validator;
+}
+
+parser_error_t parser_display_item(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
+                                   char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    const parser_tx_t *v = ctx->tx_obj;
+    display_kind_e kind = display_hash;
+    uint8_t itemIdx = 0;
+    CHECK_ERROR(parser_display_lookup(v, displayIdx, &kind, &itemIdx))
+
+    switch (kind) {
+        case display_send:
+            write_str(outKey, outKeyLen, "Send");
+            write_str(outVal, outValLen, "P chain");
+            return parser_ok;
+        case display_p_export:
+            return print_chain(ctx, v->tx.p_export_tx.destination_chain, "Export", "P to ", outKey, outKeyLen, outVal,
+                               outValLen);
+        case display_p_import:
+            return print_chain(ctx, v->tx.p_import_tx.source_chain, "Import", "P from ", outKey, outKeyLen, outVal,
+                               outValLen);
+        case display_c_export:
+            return print_chain(ctx, v->tx.c_export_tx.destination_chain, "Export", "C to ", outKey, outKeyLen, outVal,
+                               outValLen);
+        case display_c_import:
+            return print_chain(ctx, v->tx.c_import_tx.source_chain, "Import", "C from ", outKey, outKeyLen, outVal,
+                               outValLen);
+
+        case display_outputs:
+        case display_evm_outputs:
+            return print_output_item(ctx, itemIdx, NULL, "Amount", kind == display_evm_outputs, outKey, outKeyLen, outVal,
+                                     outValLen, pageIdx, pageCount);
+        case display_output_groups: {
+            uint8_t group = 0;
+            uint8_t outputItem = 0;
+            CHECK_ERROR(display_group_item(v, itemIdx, &group, &outputItem))
+            return print_output_item(ctx, outputItem, &v->out_groups.amount[group], "Amount", false, outKey, outKeyLen,
+                                     outVal, outValLen, pageIdx, pageCount);
+        }
+        case display_change_outputs:
+            return print_output_item(ctx, v->out_index.n_shown_items + itemIdx, NULL, "Change", false, outKey, outKeyLen,
+                                     outVal, outValLen, pageIdx, pageCount);
+
+        case display_node_id:
+            write_str(outKey, outKeyLen, "Validator");
+            pageString(outVal, outValLen, staking_validator(v)->node_id_str, pageIdx, pageCount);
+            return parser_ok;
+        case display_start_time:
+            write_str(outKey, outKeyLen, "Start time");
+            return printTimestamp(staking_validator(v)->start_time, outVal, outValLen, pageIdx, pageCount);
+        case display_end_time:
+            write_str(outKey, outKeyLen, "End time");
+            return printTimestamp(staking_validator(v)->end_time, outVal, outValLen, pageIdx, pageCount);
+        case display_total_stake:
+            write_str(outKey, outKeyLen, "Total stake");
+            return printAmount64(staking_validator(v)->weight, AMOUNT_DECIMAL_PLACES, v->network_id, outVal, outValLen,
+                                 pageIdx, pageCount);
+        case display_rewards_to: {
+            const uint16_t rewards_addr = (v->tx_type == add_permissionless_validator_tx)
+                                              ? v->tx.add_permissionless_validator_tx.validator_rewards_owner.addr
+                                              : v->tx.add_permissionless_delegator_tx.delegator_rewards_owner.addr;
+            write_str(outKey, outKeyLen, "Rewards to");
+            return printAddress(parser_tx_field(ctx, rewards_addr), v->network_id, outVal, outValLen, pageIdx, pageCount);
+        }
+        case display_delegate_fee: {
+            write_str(outKey, outKeyLen, "Delegate fee");
+            writer_t w;
+            writer_init(&w, outVal, outValLen);
+            writer_append_u64(&w, v->tx.add_permissionless_validator_tx.delegation_shares / 10000);
+            writer_append_str(&w, " %");
+            return parser_ok;
+        }
+
+        case display_fee:
+            write_str(outKey, outKeyLen, "Fee");
+            return printAmount64(v->summary.fee, AMOUNT_DECIMAL_PLACES, v->network_id, outVal, outValLen, pageIdx,
+                                 pageCount);
+        case display_hash:
+            write_str(outKey, outKeyLen, "Hash");
+            return printHash(ctx, outVal, outValLen, pageIdx, pageCount);
+
+        default:
+            return parser_display_idx_out_of_range;
+    }
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *  (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include "parser_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Builds the display plan of a fully parsed tx from the item list of its type
+parser_error_t parser_display_compile(parser_tx_t *v);
+
+// Items shown for the current mode: expert mode adds change and hash and lists grouped outputs one by one
+parser_error_t parser_display_num_items(const parser_tx_t *v, uint8_t *numItems);
+
+// Entry that shows displayIdx in the current mode, and the position of displayIdx within it
+parser_error_t parser_display_lookup(const parser_tx_t *v, uint8_t displayIdx, display_kind_e *kind, uint8_t *itemIdx);
+
+// Output index item rendered at itemIdx of an output entry
+parser_error_t parser_display_output_item(const parser_tx_t *v, display_kind_e kind, uint8_t itemIdx, uint8_t *outputItem);
+
+parser_error_t parser_display_item(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
+                                   char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,8 +16,11 @@
 
 #include "parser_impl.h"
 
-#include "app_mode.h"
+#include "bech32_address.h"
+#include "networks.h"
+#include "parser_display.h"
 #include "parser_impl_common.h"
+#include "parser_print_common.h"
 #include "tx_cchain.h"
 #include "tx_pchain.h"
 #include "zxmacros.h"
@@ -147,25 +150,11 @@ static parser_error_t parser_get_network_id(parser_context_t *c, parser_tx_t *v)
         return parser_init_context_empty;
     }
 
-    uint32_t netword_id = 0;
-    CHECK_ERROR(read_u32(c, &netword_id))
-
-    switch (netword_id) {
-        case MAINNET_ID:
-            v->network_id = mainnet;
-            break;
-        case COSTON_ID:
-            v->network_id = coston;
-            break;
-        case COSTON2_ID:
-            v->network_id = coston2;
-            break;
-        case SONGBIRD_ID:
-            v->network_id = songbird;
-            break;
-        default:
-            return parser_unexpected_network;
-    }
+    uint32_t raw_network_id = 0;
+    network_id_e network_id = mainnet;
+    CHECK_ERROR(read_u32(c, &raw_network_id))
+    CHECK_ERROR(network_from_id(raw_network_id, &network_id))
+    v->network_id = network_id;
     return parser_ok;
 }
 
@@ -178,21 +167,28 @@ static parser_error_t parser_verify_codec(parser_context_t *ctx) {
     return parser_ok;
 }
 
-parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
-    if (ctx == NULL || v == NULL) {
-        return parser_init_context_empty;
-    }
+static parser_error_t parser_read_steps(parser_context_t *ctx, parser_tx_t *v) {
+    if (v->stream.step == PARSER_STEP_HEADER) {
+        v->expected_asset_id = PARSER_TX_NO_OFFSET;
+        v->out_index.n_items = 0;
+        v->out_index.n_outputs = 0;
+        MEMZERO(&v->display, sizeof(v->display));
+
+        CHECK_ERROR(parser_verify_codec(ctx))
 
-    v->expected_asset_id = NULL;
+        // Read Tx type raw value
+        CHECK_ERROR(parser_map_tx_type(ctx, v));
 
-    CHECK_ERROR(parser_verify_codec(ctx))
+        // Get Network Id and Chain ID
+        CHECK_ERROR(parser_get_network_id(ctx, v));
+        CHECK_ERROR(parser_get_chain_id(ctx, v));
 
-    // Read Tx type raw value
-    CHECK_ERROR(parser_map_tx_type(ctx, v));
+        parser_stream_next_step(ctx, PARSER_STEP_BODY);
+    }
 
-    // Get Network Id and Chain ID
-    CHECK_ERROR(parser_get_network_id(ctx, v));
-    CHECK_ERROR(parser_get_chain_id(ctx, v));
+    if (v->stream.step == PARSER_STEP_DONE) {
+        return parser_ok;
+    }
 
     if (v->chain_id == c_chain) {
         CHECK_ERROR(parser_cchain(ctx, v));
@@ -200,58 +196,137 @@ parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
         CHECK_ERROR(parser_pchain(ctx, v));
     }
 
+    return parser_ok;
+}
+
+// Address the signing key receives its change on
+static uint8_t change_address[ADDRESS_LEN];
+static bool change_address_set = false;
+
+parser_error_t _set_change_address(const uint8_t *address, uint16_t addressLen) {
+    MEMZERO(change_address, sizeof(change_address));
+    change_address_set = false;
+    if (address == NULL) {
+        return parser_ok;
+    }
+    if (addressLen != sizeof(change_address)) {
+        return parser_unexpected_data_len;
+    }
+    MEMCPY(change_address, address, sizeof(change_address));
+    change_address_set = true;
+    return parser_ok;
+}
+
+parser_error_t _read_chunk(parser_context_t *ctx, parser_tx_t *v, bool last) {
+    if (ctx == NULL || v == NULL) {
+        return parser_init_context_empty;
+    }
+
+    // Resume right after the last fully parsed step or record
+    ctx->offset = v->stream.offset;
+    const parser_error_t err = parser_read_steps(ctx, v);
+    if (err == parser_unexpected_buffer_end && !last) {
+        // Wait for the next chunk
+        ctx->offset = v->stream.offset;
+        return parser_ok;
+    }
+    CHECK_ERROR(err)
+
+    if (last && v->stream.step != PARSER_STEP_DONE) {
+        return parser_unexpected_buffer_end;
+    }
+
+    if (v->stream.step != PARSER_STEP_DONE) {
+        return parser_ok;
+    }
+
     if (ctx->offset != ctx->bufferLen) {
         return parser_unexpected_unparsed_bytes;
     }
 
-    return parser_ok;
+    // Totals, fee and the review are known once the whole tx is parsed
+    if (v->chain_id == c_chain) {
+        CHECK_ERROR(parser_summary_cchain(v))
+    } else {
+        CHECK_ERROR(parser_summary_pchain(v))
+    }
+
+    // Only plain sends hide their change; what atomic txs output is what moves across chains
+    const bool hide_change = change_address_set && v->tx_type == base_tx;
+    CHECK_ERROR(parser_hide_change_outputs(ctx, &v->out_index, hide_change ? change_address : NULL))
+
+    // C-chain imports pay EVM outputs, which have no spending conditions to group by
+    MEMZERO(&v->out_groups, sizeof(v->out_groups));
+    if (v->tx_type != c_import_tx) {
+        CHECK_ERROR(parser_group_outputs(ctx, &v->out_index, &v->out_groups))
+    }
+    return parser_display_compile(v);
+}
+
+parser_error_t _read(parser_context_t *ctx, parser_tx_t *v) {
+    if (ctx == NULL || v == NULL) {
+        return parser_init_context_empty;
+    }
+
+    MEMZERO(&v->stream, sizeof(v->stream));
+    return _read_chunk(ctx, v, true);
 }
 
 parser_error_t getNumItems(const parser_context_t *ctx, uint8_t *numItems) {
-    *numItems = 0;
-    const uint32_t expertModeHashField = app_mode_expert() ? 1U : 0U;
-    uint32_t total = 0;
-    switch (ctx->tx_obj->tx_type) {
-        case base_tx:
-            // Tx + fee + Amounts(= n_outs) + Addresses
-            total = 2U + ctx->tx_obj->tx.base_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.base_tx.base_secp_outs.n_outs +
-                    expertModeHashField;
-            break;
-        case p_export_tx:
-            // Tx + fee + Amounts(= n_outs) + Addresses
-            total = 2U + ctx->tx_obj->tx.p_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.p_export_tx.secp_outs.n_outs +
-                    expertModeHashField;
-            break;
-        case p_import_tx:
-            // Tx + fee + Amounts(= n_outs) + Addresses
-            total = 2U + ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_addrs +
-                    ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_outs + expertModeHashField;
-            break;
-        case c_export_tx:
-            // Tx + fee + Amounts(= n_outs) + Addresses
-            total = 2U + ctx->tx_obj->tx.c_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.c_export_tx.secp_outs.n_outs +
-                    expertModeHashField;
-            break;
-        case c_import_tx:
-            // Tx + fee + (amount + address) * n_outs
-            total = 2U + (2U * ctx->tx_obj->tx.c_import_tx.evm_outs.n_outs) + expertModeHashField;
-            break;
-        case add_permissionless_delegator_tx:
-            total = 6U + expertModeHashField;
-            break;
-        case add_permissionless_validator_tx:
-            total = 7U + expertModeHashField;
-            break;
-        default:
-            break;
+    return parser_display_num_items(ctx->tx_obj, numItems);
+}
+
+parser_error_t getItemValueLen(const parser_context_t *ctx, uint8_t displayIdx, uint16_t *len) {
+    uint8_t numItems = 0;
+    CHECK_ERROR(getNumItems(ctx, &numItems))
+    if (displayIdx >= numItems) {
+        return parser_display_idx_out_of_range;
     }
 
-    if (total == 0) {
-        return parser_unexpected_number_items;
+    const parser_tx_t *v = ctx->tx_obj;
+    display_kind_e kind = display_hash;
+    uint8_t itemIdx = 0;
+    CHECK_ERROR(parser_display_lookup(v, displayIdx, &kind, &itemIdx))
+
+    const network_info_t *network = network_get(v->network_id);
+    if (network == NULL) {
+        return parser_unexpected_error;
     }
-    if (total > UINT8_MAX) {
-        return parser_unexpected_number_items;
+    const uint16_t address_len = BECH32_ADDRESS_STR_LEN(strnlen(network->hrp, NETWORK_HRP_LEN));
+
+    switch (kind) {
+        case display_outputs:
+        case display_output_groups:
+        case display_change_outputs:
+        case display_evm_outputs: {
+            uint8_t element_idx = 0;
+            uint64_t amount = 0;
+            uint8_t address[ADDRESS_LEN];
+            CHECK_ERROR(parser_display_output_item(v, kind, itemIdx, &itemIdx))
+            CHECK_ERROR(parser_get_output_item(ctx, itemIdx, &amount, address, &element_idx))
+            if (!element_idx) {
+                return parser_no_data;
+            }
+            // C-chain imports pay to 0x-prefixed EVM addresses
+            *len = (kind == display_evm_outputs) ? 2 + 2 * ADDRESS_LEN : address_len;
+            return parser_ok;
+        }
+        case display_node_id: {
+            const validator_t *validator = (v->tx_type == add_permissionless_validator_tx)
+                                               ? &v->tx.add_permissionless_validator_tx.validator
+                                               : &v->tx.add_permissionless_delegator_tx.validator;
+            *len = (uint16_t)strnlen(validator->node_id_str, sizeof(validator->node_id_str));
+            return parser_ok;
+        }
+        case display_start_time:
+        case display_end_time:
+            *len = TIMESTAMP_STR_LEN;
+            return parser_ok;
+        case display_rewards_to:
+            *len = address_len;
+            return parser_ok;
+        default:
+            // Amounts and the like vary, the expert mode hash is paged as hex by the caller
+            return parser_no_data;
     }
-    *numItems = (uint8_t)total;
-    return parser_ok;
 }
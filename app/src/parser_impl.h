@@ -26,7 +26,14 @@ extern "C" {
 #endif
 
 parser_error_t _read(parser_context_t *ctx, parser_tx_t *v);
+// Parses the bytes received so far, resuming from v->stream. Unless last is
+// set, running out of data is not an error: parsing resumes on the next call.
+parser_error_t _read_chunk(parser_context_t *ctx, parser_tx_t *v, bool last);
+// Change address used when the last chunk is parsed, NULL to show every output
+parser_error_t _set_change_address(const uint8_t *address, uint16_t addressLen);
 parser_error_t getNumItems(const parser_context_t *ctx, uint8_t *numItems);
+// Length of the rendered value of displayIdx when its type fixes it, parser_no_data otherwise
+parser_error_t getItemValueLen(const parser_context_t *ctx, uint8_t displayIdx, uint16_t *len);
 const char *parser_getErrorDescription(parser_error_t err);
 #ifdef __cplusplus
 }
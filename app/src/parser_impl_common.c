@@ -17,83 +17,18 @@
 
 #include "bech32.h"
 #include "crypto.h"
+#include "networks.h"
+#include "parser_codec.h"
 #include "parser_common.h"
 #include "zxformat.h"
 #include "zxmacros.h"
 
-static const chain_lookup_table_t chain_lookup_table[] = {
-
-    // Flare
-    {{0x77, 0xd3, 0x07, 0x4d, 0xc5, 0x10, 0xf4, 0x3b, 0x09, 0xac, 0x5b, 0xe7, 0x7e, 0xde, 0xe2, 0x76,
-      0xef, 0x3b, 0x55, 0xf0, 0x09, 0x7d, 0x50, 0x48, 0x46, 0xaa, 0x8e, 0xec, 0x61, 0x3f, 0xc6, 0x25},
-     c_chain,
-     'C'},
-    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
-     p_chain,
-     'P'},
-
-    // Coston2
-    {{0x78, 0xdb, 0x5c, 0x30, 0xbe, 0xd0, 0x4c, 0x05, 0xce, 0x20, 0x91, 0x79, 0x81, 0x28, 0x50, 0xbb,
-      0xb3, 0xfe, 0x6d, 0x46, 0xd7, 0xee, 0xf3, 0x74, 0x4d, 0x81, 0x4c, 0x0d, 0xa5, 0x55, 0x24, 0x79},
-     c_chain,
-     'C'},
-    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
-     p_chain,
-     'P'},
-
-    // Songbird
-    {{0x55, 0xf0, 0x77, 0xed, 0x33, 0x88, 0x89, 0x8d, 0x7c, 0x52, 0xc1, 0xa1, 0x0c, 0xae, 0x70, 0xe8,
-      0x34, 0x50, 0xc3, 0x34, 0x99, 0xf4, 0xeb, 0x1a, 0xe8, 0x18, 0x77, 0xb6, 0xf8, 0xfd, 0xa4, 0x02},
-     c_chain,
-     'C'},
-    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
-     p_chain,
-     'P'},
-
-    // Coston
-    {{0xff, 0xb1, 0x19, 0xb4, 0x04, 0xc1, 0x35, 0x6b, 0x6b, 0xfd, 0xb8, 0x00, 0x45, 0xe2, 0x7b, 0xa1,
-      0x3c, 0x37, 0x89, 0xb5, 0xb3, 0x68, 0x4f, 0x00, 0x1d, 0xa0, 0x71, 0xcd, 0x4e, 0x6d, 0xb0, 0x9c},
-     c_chain,
-     'C'},
-    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
-     p_chain,
-     'P'},
-
-};
-
-static const uint32_t chain_lookup_len = sizeof(chain_lookup_table) / sizeof(chain_lookup_table[0]);
-
 // Checks that there are at least SIZE bytes available in the buffer
 #define CTX_CHECK_AVAIL(CTX, SIZE)                                      \
     if ((CTX) == NULL || ((CTX)->offset + (SIZE)) > (CTX)->bufferLen) { \
         return parser_unexpected_buffer_end;                            \
     }
 
-// Consume the next ASSET_ID_LEN bytes and verify they match every previously
-// parsed asset ID on this transaction. The first asset ID seen is captured
-// as the expected one; any later mismatch is rejected. Flare's P-chain
-// staking/import/export and C-chain atomic flows are native-asset-only, so
-// every asset ID in a valid tx must be identical.
-static parser_error_t verify_asset_id(parser_context_t *c) {
-    if (c == NULL || c->offset + ASSET_ID_LEN > c->bufferLen) {
-        return parser_unexpected_buffer_end;
-    }
-    const uint8_t *asset_ptr = c->buffer + c->offset;
-    if (c->tx_obj != NULL) {
-        if (c->tx_obj->expected_asset_id == NULL) {
-            c->tx_obj->expected_asset_id = asset_ptr;
-        } else if (MEMCMP(c->tx_obj->expected_asset_id, asset_ptr, ASSET_ID_LEN) != 0) {
-            return parser_unexpected_network;
-        }
-    }
-    c->offset += ASSET_ID_LEN;
-    return parser_ok;
-}
-
 #define CTX_CHECK_AND_ADVANCE(CTX, SIZE) \
     CTX_CHECK_AVAIL((CTX), (SIZE))       \
     (CTX)->offset += (SIZE);
@@ -107,14 +42,9 @@ parser_error_t read_u64(parser_context_t *ctx, uint64_t *result) {
     if (result == NULL) {
         return parser_unexpected_error;
     }
-
     CTX_CHECK_AVAIL(ctx, sizeof(uint64_t));
 
-    *result = 0;  // Initialize result
-
-    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
-        *result = (*result << 8) | ctx->buffer[i + ctx->offset];
-    }
+    *result = codec_read_be64(ctx->buffer + ctx->offset);
     ctx->offset += sizeof(uint64_t);
 
     return parser_ok;
@@ -126,11 +56,7 @@ parser_error_t read_u32(parser_context_t *ctx, uint32_t *result) {
     }
     CTX_CHECK_AVAIL(ctx, sizeof(uint32_t));
 
-    *result = 0;  // Initialize result
-
-    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
-        *result = (*result << 8) | ctx->buffer[i + ctx->offset];
-    }
+    *result = codec_read_be32(ctx->buffer + ctx->offset);
     ctx->offset += sizeof(uint32_t);
 
     return parser_ok;
@@ -142,13 +68,9 @@ parser_error_t read_u16(parser_context_t *ctx, uint16_t *result) {
     }
     CTX_CHECK_AVAIL(ctx, sizeof(uint16_t));
 
-    *result = 0;  // Initialize result
-
-    for (size_t i = 0; i < sizeof(uint16_t); ++i) {
-        *result = (*result << 8) | ctx->buffer[i + ctx->offset];
-    }
-
+    *result = codec_read_be16(ctx->buffer + ctx->offset);
     ctx->offset += sizeof(uint16_t);
+
     return parser_ok;
 }
 
@@ -174,6 +96,16 @@ parser_error_t verifyContext(parser_context_t *ctx) {
     return parser_ok;
 }
 
+parser_error_t read_count(parser_context_t *ctx, uint8_t max, uint8_t *result) {
+    uint32_t count = 0;
+    CHECK_ERROR(read_u32(ctx, &count))
+    if (count > max) {
+        return parser_unexpected_number_items;
+    }
+    *result = (uint8_t)count;
+    return parser_ok;
+}
+
 parser_error_t verifyBytes(parser_context_t *ctx, uint16_t buffLen) {
     CTX_CHECK_AND_ADVANCE(ctx, buffLen)
     return parser_ok;
@@ -191,226 +123,197 @@ parser_error_t parser_get_chain_id(parser_context_t *c, parser_tx_t *v) {
         return parser_unexpected_error;
     }
 
-    v->blockchain_id = c->buffer + c->offset;
+    const uint16_t blockchain_id = c->offset;
     CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN))
 
-    for (size_t i = 0; i < chain_lookup_len; i++) {
-        if (MEMCMP(chain_lookup_table[i].blockchain_id, v->blockchain_id, BLOCKCHAIN_ID_LEN) == 0) {
-            v->chain_id = chain_lookup_table[i].chain;
-            return parser_ok;
-        }
-    }
-    return parser_unexpected_chain;
+    chain_id_e chain_id = p_chain;
+    char alias = 0;
+    CHECK_ERROR(network_chain_lookup(v->network_id, c->buffer + blockchain_id, &chain_id, &alias))
+    v->blockchain_id = blockchain_id;
+    v->chain_id = chain_id;
+    return parser_ok;
 }
 
-parser_error_t parser_get_chain_alias(const uint8_t *blockchain_id, char *chain) {
+parser_error_t parser_get_chain_alias(network_id_e network, const uint8_t *blockchain_id, char *chain) {
     if (blockchain_id == NULL) {
         return parser_unexpected_error;
     }
 
-    for (size_t i = 0; i < array_length(chain_lookup_table); i++) {
-        if (MEMCMP(chain_lookup_table[i].blockchain_id, blockchain_id, BLOCKCHAIN_ID_LEN) == 0) {
-            *chain = chain_lookup_table[i].name;
-            return parser_ok;
-        }
-    }
-    return parser_unexpected_chain;
+    chain_id_e chain_id = p_chain;
+    return network_chain_lookup(network, blockchain_id, &chain_id, chain);
 }
 
-parser_error_t parse_evm_inputs(parser_context_t *c, evm_inputs_t *evm) {
-    if (evm == NULL) {
-        return parser_unexpected_error;
-    }
-    evm->in_sum = 0;
-
-    // Validate n_ins to prevent excessive iterations
-    if (evm->n_ins > MAX_INPUTS) {
-        return parser_unexpected_number_items;
-    }
-
-    for (uint32_t i = 0; i < evm->n_ins; i++) {
-        // Skip address
-        CHECK_ERROR(verifyBytes(c, ADDRESS_LEN));
+void parser_stream_next_step(parser_context_t *c, uint8_t step) {
+    c->tx_obj->stream.step = step;
+    c->tx_obj->stream.item = 0;
+    c->tx_obj->stream.offset = c->offset;
+}
 
-        // Save amount
-        uint64_t amount = 0;
-        CHECK_ERROR(read_u64(c, &amount));
+void parser_stream_next_item(parser_context_t *c) {
+    c->tx_obj->stream.item++;
+    c->tx_obj->stream.offset = c->offset;
+}
 
-        // Check for overflow before adding amount
-        if (evm->in_sum > UINT64_MAX - amount) {
-            return parser_value_out_of_range;
-        }
-        evm->in_sum += amount;
+// EVMInput: address, amount, asset ID, nonce
+enum { evm_input_amount };
+static const codec_field_t evm_input_fields[] = {
+    CODEC_SKIP(ADDRESS_LEN),
+    CODEC_U64(evm_input_amount),
+    CODEC_ASSET_ID(),
+    CODEC_SKIP(NONCE_LEN),
+};
+static const codec_schema_t evm_input_schema = CODEC_SCHEMA(evm_input_fields);
+
+// EVMOutput: address, amount, asset ID
+enum { evm_output_address, evm_output_amount };
+static const codec_field_t evm_output_fields[] = {
+    CODEC_BYTES(ADDRESS_LEN, evm_output_address),
+    CODEC_U64(evm_output_amount),
+    CODEC_ASSET_ID(),
+};
+static const codec_schema_t evm_output_schema = CODEC_SCHEMA(evm_output_fields);
+
+// TransferableOutput holding a SECP256K1TransferOutput
+enum { secp_output_amount, secp_output_locktime, secp_output_threshold, secp_output_addresses };
+static const codec_field_t secp_output_fields[] = {
+    CODEC_ASSET_ID(),
+    CODEC_TYPE_ID(SECP_TYPE_ID),
+    CODEC_U64(secp_output_amount),
+    CODEC_U64(secp_output_locktime),
+    CODEC_U32(secp_output_threshold),
+    CODEC_ARRAY(ADDRESS_LEN, MAX_OUTPUTS, secp_output_addresses),
+};
+static const codec_schema_t secp_output_schema = CODEC_SCHEMA(secp_output_fields);
+
+// TransferableInput holding a SECP256K1TransferInput
+enum { secp_input_amount, secp_input_sig_indices };
+static const codec_field_t secp_input_fields[] = {
+    CODEC_SKIP(TX_ID_LEN),
+    CODEC_SKIP(UTXOINDEX),
+    CODEC_ASSET_ID(),
+    CODEC_TYPE_ID(SECP_INPUT_TYPE_ID),
+    CODEC_U64(secp_input_amount),
+    CODEC_ARRAY(sizeof(uint32_t), MAX_OUTPUTS, secp_input_sig_indices),
+};
+static const codec_schema_t secp_input_schema = CODEC_SCHEMA(secp_input_fields);
+
+// SECP256K1OutputOwners
+enum { secp_owners_threshold, secp_owners_addresses };
+static const codec_field_t secp_owners_fields[] = {
+    CODEC_TYPE_ID(SECP_OWNERS_TYPE_ID),
+    CODEC_SKIP(LOCKTIME_LEN),
+    CODEC_U32(secp_owners_threshold),
+    CODEC_ARRAY(ADDRESS_LEN, MAX_OUTPUTS, secp_owners_addresses),
+};
+static const codec_schema_t secp_owners_schema = CODEC_SCHEMA(secp_owners_fields);
 
-        // Verify assetID matches the tx-wide native asset and advance.
-        CHECK_ERROR(verify_asset_id(c));
+parser_error_t parse_evm_input_record(parser_context_t *c, evm_inputs_t *evm) {
+    codec_record_t record;
+    CHECK_ERROR(codec_decode(c, &evm_input_schema, &record));
+    const uint64_t amount = record.value[evm_input_amount];
 
-        // Skip nonce
-        CHECK_ERROR(verifyBytes(c, NONCE_LEN));
+    // Check for overflow before adding amount
+    if (evm->in_sum > UINT64_MAX - amount) {
+        return parser_value_out_of_range;
     }
+    evm->in_sum += amount;
 
     return parser_ok;
 }
 
-parser_error_t parse_transferable_secp_output(parser_context_t *c, transferable_out_secp_t *outputs, bool verify_locktime) {
-    if (outputs == NULL) {
-        return parser_unexpected_error;
+// Append an output rendered as its amount followed by n_addresses addresses
+static parser_error_t output_index_push(output_index_t *index, uint16_t amount_offset, uint16_t addresses_offset,
+                                        uint32_t n_addresses) {
+    if (index == NULL) {
+        return parser_ok;
     }
-    outputs->out_sum = 0;
-
-    // Validate n_outs to prevent excessive iterations
-    if (outputs->n_outs > MAX_OUTPUTS) {
+    if (index->n_outputs >= MAX_OUTPUTS || (uint32_t)index->n_items + 1 + n_addresses > MAX_OUTPUT_ITEMS) {
         return parser_unexpected_number_items;
     }
 
-    for (uint32_t i = 0; i < outputs->n_outs; i++) {
-        // Verify assetId matches the tx-wide native asset and advance.
-        CHECK_ERROR(verify_asset_id(c));
-
-        // Skip typeID
-        uint32_t typeID = 0;
-        CHECK_ERROR(read_u32(c, &typeID));
-        if (typeID != SECP_TYPE_ID) {
-            return parser_unexpected_type_id;
-        }
-
-        // Save amount to total
-        uint64_t amount = 0;
-        CHECK_ERROR(read_u64(c, &amount));
-
-        // Check for overflow before adding amount
-        if (outputs->out_sum > UINT64_MAX - amount) {
-            return parser_value_out_of_range;
-        }
-        outputs->out_sum += amount;
-
-        // Skip locktime
-        uint64_t locktime = 0;
-        CHECK_ERROR(read_u64(c, &locktime));
-        if (verify_locktime && locktime != 0) {
-            return parser_unexpected_output_locked;
-        }
-
-        // Get threshold
-        uint32_t threshold = 0;
-        CHECK_ERROR(read_u32(c, &threshold));
-
-        // Get number of Addresses
-        uint32_t tmp_n_adresses = 0;
-        CHECK_ERROR(read_u32(c, &tmp_n_adresses));
-
-        if (threshold > tmp_n_adresses || (tmp_n_adresses == 0 && threshold != 0)) {
-            return parser_unexpected_threshold;
-        }
-
-        // Validate tmp_n_adresses to prevent excessive iterations
-        if (tmp_n_adresses > MAX_OUTPUTS) {
-            return parser_unexpected_number_items;
-        }
-
-        CHECK_ERROR(checkAvailableBytes(c, tmp_n_adresses * ADDRESS_LEN));
-
-        for (uint32_t j = 0; j < tmp_n_adresses; j++) {
-            verifyBytes(c, ADDRESS_LEN);
-            outputs->n_addrs++;
-            // Cap aggregate address count so the UI item total (2 + n_addrs + n_outs + expert)
-            // cannot wrap the uint8_t numItems used by the display layer.
-            if (outputs->n_addrs > (uint32_t)(UINT8_MAX - MAX_OUTPUTS - 3U)) {
-                return parser_unexpected_number_items;
-            }
+    // Every output of a set shares its record layout
+    const int32_t delta = (int32_t)addresses_offset - (int32_t)amount_offset;
+    if (index->n_outputs == 0) {
+        if (delta < INT8_MIN || delta > INT8_MAX) {
+            return parser_unexpected_error;
         }
+        index->address_delta = (int8_t)delta;
+    } else if (delta != index->address_delta) {
+        return parser_unexpected_error;
     }
 
+    index->first_item[index->n_outputs] = index->n_items;
+    index->amount[index->n_outputs] = amount_offset;
+    index->n_outputs++;
+    index->n_items += (uint8_t)(1 + n_addresses);
     return parser_ok;
 }
 
-parser_error_t parse_evm_output(parser_context_t *c, evm_outs_t *outputs) {
-    if (outputs == NULL) {
-        return parser_unexpected_error;
-    }
-    outputs->out_sum = 0;
+parser_error_t parse_transferable_secp_output_record(parser_context_t *c, transferable_out_secp_t *outputs,
+                                                     bool verify_locktime, output_index_t *index) {
+    codec_record_t record;
+    CHECK_ERROR(codec_decode(c, &secp_output_schema, &record));
+    const uint64_t amount = record.value[secp_output_amount];
+    const uint64_t threshold = record.value[secp_output_threshold];
+    const uint32_t n_addresses = (uint32_t)record.value[secp_output_addresses];
 
-    // Validate n_outs to prevent excessive iterations
-    if (outputs->n_outs > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
+    if (verify_locktime && record.value[secp_output_locktime] != 0) {
+        return parser_unexpected_output_locked;
     }
 
-    for (uint32_t i = 0; i < outputs->n_outs; i++) {
-        // Check address is renderable
-        verifyBytes(c, ADDRESS_LEN);
-
-        // Save amount to total
-        uint64_t amount = 0;
-        CHECK_ERROR(read_u64(c, &amount));
-
-        // Check for overflow before adding amount
-        if (outputs->out_sum > UINT64_MAX - amount) {
-            return parser_value_out_of_range;
-        }
-        outputs->out_sum += amount;
-
-        // Verify assetId matches the tx-wide native asset and advance.
-        CHECK_ERROR(verify_asset_id(c));
+    if (threshold > n_addresses || (n_addresses == 0 && threshold != 0)) {
+        return parser_unexpected_threshold;
     }
 
-    return parser_ok;
-}
-
-parser_error_t parse_transferable_secp_input(parser_context_t *c, transferable_in_secp_t *inputs) {
-    if (inputs == NULL) {
-        return parser_unexpected_error;
+    // The whole record is in the buffer, account for it
+    // Cap aggregate address count so the UI item total (2 + n_addrs + n_outs + expert)
+    // cannot wrap the uint8_t numItems used by the display layer.
+    if (outputs->n_addrs + n_addresses > (uint32_t)(UINT8_MAX - MAX_OUTPUTS - 3U)) {
+        return parser_unexpected_number_items;
     }
-    inputs->in_sum = 0;
 
-    // Validate n_ins to prevent excessive iterations
-    if (inputs->n_ins > MAX_INPUTS) {
-        return parser_unexpected_number_items;
+    // Check for overflow before adding amount
+    if (outputs->out_sum > UINT64_MAX - amount) {
+        return parser_value_out_of_range;
     }
 
-    for (uint32_t i = 0; i < inputs->n_ins; i++) {
-        // skip TxID
-        CHECK_ERROR(verifyBytes(c, TX_ID_LEN));
+    CHECK_ERROR(output_index_push(index, record.offset[secp_output_amount], record.offset[secp_output_addresses],
+                                  n_addresses));
 
-        // skip UTXOIndex
-        CHECK_ERROR(verifyBytes(c, UTXOINDEX));
+    outputs->out_sum += amount;
+    outputs->n_addrs += (uint8_t)n_addresses;
 
-        // Verify ASSET_ID matches the tx-wide native asset and advance.
-        CHECK_ERROR(verify_asset_id(c));
+    return parser_ok;
+}
 
-        // Skip typeID
-        uint32_t typeID = 0;
-        CHECK_ERROR(read_u32(c, &typeID));
-        if (typeID != SECP_INPUT_TYPE_ID) {
-            return parser_unexpected_type_id;
-        }
+parser_error_t parse_evm_output_record(parser_context_t *c, evm_outs_t *outputs, output_index_t *index) {
+    codec_record_t record;
+    CHECK_ERROR(codec_decode(c, &evm_output_schema, &record));
+    const uint64_t amount = record.value[evm_output_amount];
 
-        // Save amount
-        uint64_t amount = 0;
-        CHECK_ERROR(read_u64(c, &amount));
+    // Check for overflow before adding amount
+    if (outputs->out_sum > UINT64_MAX - amount) {
+        return parser_value_out_of_range;
+    }
 
-        // Check for overflow before adding amount
-        if (inputs->in_sum > UINT64_MAX - amount) {
-            return parser_value_out_of_range;
-        }
-        inputs->in_sum += amount;
+    // Amount is rendered before the address it pays to
+    CHECK_ERROR(output_index_push(index, record.offset[evm_output_amount], record.offset[evm_output_address], 1));
 
-        // Get Address indices
-        uint32_t n_indices = 0;
-        CHECK_ERROR(read_u32(c, &n_indices));
+    outputs->out_sum += amount;
 
-        // Validate n_indices to prevent overflow when multiplying by sizeof(uint32_t)
-        if (n_indices > UINT16_MAX / sizeof(uint32_t)) {
-            return parser_value_out_of_range;
-        }
+    return parser_ok;
+}
 
-        // Validate n_indices to prevent excessive iterations
-        if (n_indices > MAX_OUTPUTS) {
-            return parser_unexpected_number_items;
-        }
+parser_error_t parse_transferable_secp_input_record(parser_context_t *c, transferable_in_secp_t *inputs) {
+    codec_record_t record;
+    CHECK_ERROR(codec_decode(c, &secp_input_schema, &record));
+    const uint64_t amount = record.value[secp_input_amount];
 
-        // skip addresses
-        CHECK_ERROR(verifyBytes(c, sizeof(uint32_t) * n_indices));
+    // Check for overflow before adding amount
+    if (inputs->in_sum > UINT64_MAX - amount) {
+        return parser_value_out_of_range;
     }
+    inputs->in_sum += amount;
 
     return parser_ok;
 }
@@ -426,23 +329,10 @@ parser_error_t parse_secp_owners_output(parser_context_t *c, secp_owners_out_t *
     }
 
     for (uint32_t i = 0; i < outputs->n_outs; i++) {
-        // Skip typeID
-        uint32_t typeID = 0;
-        CHECK_ERROR(read_u32(c, &typeID));
-        if (typeID != SECP_OWNERS_TYPE_ID) {
-            return parser_unexpected_type_id;
-        }
-
-        // Skip locktime
-        CHECK_ERROR(verifyBytes(c, LOCKTIME_LEN));
-
-        // Get threshold
-        uint32_t threshold = 0;
-        CHECK_ERROR(read_u32(c, &threshold));
-
-        // Get number of Addresses
-        uint32_t n_addresses = 0;
-        CHECK_ERROR(read_u32(c, &n_addresses));
+        codec_record_t record;
+        CHECK_ERROR(codec_decode(c, &secp_owners_schema, &record));
+        const uint64_t threshold = record.value[secp_owners_threshold];
+        const uint32_t n_addresses = (uint32_t)record.value[secp_owners_addresses];
 
         // Reward-owner UI renders a single address and never shows the
         // threshold or additional signers. Reject anything other than the
@@ -452,99 +342,165 @@ parser_error_t parse_secp_owners_output(parser_context_t *c, secp_owners_out_t *
             return parser_unexpected_threshold;
         }
 
-        outputs->n_addr += n_addresses;
-
-        // skip addresses
-        outputs->addr = c->buffer + c->offset;
-        CHECK_ERROR(verifyBytes(c, ADDRESS_LEN * n_addresses));
+        outputs->addr = record.offset[secp_owners_addresses];
+        outputs->n_addr++;
     }
 
     return parser_ok;
 }
 
-parser_error_t parser_go_to_next_transferable_output(parser_context_t *c) {
-    if (c == NULL) {
-        return parser_init_context_empty;
+parser_error_t parser_get_output_item(const parser_context_t *ctx, uint8_t item_idx, uint64_t *amount, uint8_t *address,
+                                      uint8_t *element_idx) {
+    if (ctx == NULL || ctx->tx_obj == NULL || amount == NULL || address == NULL || element_idx == NULL) {
+        return parser_unexpected_error;
     }
-    c->offset += ADDRESS_OFFSET;
-    uint32_t n_addresses = 0;
-    CHECK_ERROR(read_u32(c, &n_addresses));
 
-    // Validate n_addresses to prevent overflow when multiplying by ADDRESS_LEN
-    if (n_addresses > UINT16_MAX / ADDRESS_LEN) {
-        return parser_value_out_of_range;
+    const output_index_t *index = &ctx->tx_obj->out_index;
+    if (item_idx >= index->n_items) {
+        return parser_unexpected_number_items;
     }
 
-    // Validate n_addresses to prevent excessive iterations
-    if (n_addresses > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
+    // Last output whose first item is not past item_idx
+    uint8_t lo = 0;
+    uint8_t hi = index->n_outputs;
+    while (hi - lo > 1) {
+        const uint8_t mid = (uint8_t)((lo + hi) / 2);
+        if (index->first_item[mid] <= item_idx) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
     }
 
-    CHECK_ERROR(verifyBytes(c, ADDRESS_LEN * n_addresses));
+    const uint8_t element = item_idx - index->first_item[lo];
+    parser_context_t item_ctx = {
+        .buffer = ctx->buffer, .bufferLen = ctx->bufferLen, .offset = index->amount[lo], .tx_obj = NULL};
 
-    return parser_ok;
+    if (element != 0) {
+        item_ctx.offset = (uint16_t)(item_ctx.offset + index->address_delta + (element - 1) * ADDRESS_LEN);
+        *element_idx = 1;
+        return readBytes(&item_ctx, address, ADDRESS_LEN);
+    }
+
+    *element_idx = 0;
+    return read_u64(&item_ctx, amount);
+}
+
+// Items output k of the index is shown as: its amount and its addresses
+static uint8_t output_index_items(const output_index_t *index, uint8_t k) {
+    const uint8_t end = (k + 1 < index->n_outputs) ? index->first_item[k + 1] : index->n_items;
+    return end - index->first_item[k];
+}
+
+// In a secp output record the locktime, threshold and address count sit right before the addresses
+static uint16_t output_locktime_offset(const output_index_t *index, uint8_t k) {
+    return (uint16_t)(index->amount[k] + index->address_delta - LOCKTIME_LEN - THRESHOLD_LEN - sizeof(uint32_t));
 }
 
-parser_error_t parser_get_secp_output_for_index(parser_context_t *out_ctx, transferable_out_secp_t secp_outs,
-                                                uint8_t inner_displayIdx, uint64_t *amount, uint8_t *address,
-                                                uint8_t *element_idx) {
-    if (amount == NULL || address == NULL || element_idx == NULL) {
+parser_error_t parser_hide_change_outputs(const parser_context_t *ctx, output_index_t *index,
+                                          const uint8_t *change_address) {
+    if (ctx == NULL || index == NULL) {
         return parser_unexpected_error;
     }
-    uint64_t count = 0;
-    uint32_t out_n_addr = 0;
-    for (uint32_t i = 0; i < secp_outs.n_outs; i++) {
-        // read amount and check if its the index we are looking for return element 0 for amount print
-        CHECK_ERROR(verifyBytes(out_ctx, AMOUNT_OFFSET));
-        CHECK_ERROR(read_u64(out_ctx, amount));
-        if (count == inner_displayIdx) {
-            *element_idx = 0;
-            return parser_ok;
+    index->n_shown_items = index->n_items;
+    if (change_address == NULL || index->n_outputs == 0) {
+        return parser_ok;
+    }
+
+    // Change pays a single owner, with threshold 1 and no locktime
+    uint64_t renderable = 0;
+    for (uint8_t k = 0; k < index->n_outputs; k++) {
+        const uint16_t addresses = (uint16_t)(index->amount[k] + index->address_delta);
+        const uint8_t *p = ctx->buffer + output_locktime_offset(index, k);
+        const bool change = output_index_items(index, k) == 2 && codec_read_be64(p) == 0 &&
+                            codec_read_be32(p + LOCKTIME_LEN) == 1 &&
+                            MEMCMP(ctx->buffer + addresses, change_address, ADDRESS_LEN) == 0;
+        if (!change) {
+            renderable |= (uint64_t)1 << k;
         }
-        count++;  // Increment count after checking amount
-
-        CHECK_ERROR(verifyBytes(out_ctx, N_ADDRESS_OFFSET));
-        CHECK_ERROR(read_u32(out_ctx, &out_n_addr));
-
-        // Validate out_n_addr to prevent excessive iterations
-        if (out_n_addr > MAX_OUTPUTS) {
-            return parser_unexpected_number_items;
+    }
+    const uint8_t n_renderable = (uint8_t)parser_get_renderable_outputs_number(renderable);
+    if (n_renderable == index->n_outputs) {
+        return parser_ok;
+    }
+
+    // Stable partition: renderable outputs first, then change
+    uint8_t items[MAX_OUTPUTS];
+    uint16_t amount[MAX_OUTPUTS];
+    uint8_t n = 0;
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t k = 0; k < index->n_outputs; k++) {
+            if (((renderable >> k) & 1) == (pass == 0 ? 1U : 0U)) {
+                items[n] = output_index_items(index, k);
+                amount[n] = index->amount[k];
+                n++;
+            }
         }
+    }
 
-        // Make sure N addresses are available
-        CHECK_ERROR(checkAvailableBytes(out_ctx, out_n_addr * ADDRESS_LEN));
-
-        // Go through output addresses and check if its the index we are looking for return element >0 for address print
-        for (uint32_t j = 1; j <= out_n_addr; j++) {
-            CHECK_ERROR(readBytes(out_ctx, address, ADDRESS_LEN));
-            if (count == inner_displayIdx) {
-                *element_idx = j;
-                return parser_ok;
-            }
-            count++;
+    uint8_t first_item = 0;
+    for (uint8_t k = 0; k < index->n_outputs; k++) {
+        if (k == n_renderable) {
+            index->n_shown_items = first_item;
         }
+        index->first_item[k] = first_item;
+        index->amount[k] = amount[k];
+        first_item += items[k];
     }
-    return parser_unexpected_number_items;
+    return parser_ok;
 }
 
-parser_error_t parser_get_evm_output_index(parser_context_t *out_ctx, evm_outs_t evm_outs, uint8_t out_index,
-                                           uint64_t *amount, uint8_t *address) {
-    if (amount == NULL || address == NULL) {
+parser_error_t parser_group_outputs(const parser_context_t *ctx, const output_index_t *index, output_groups_t *groups) {
+    if (ctx == NULL || index == NULL || groups == NULL) {
         return parser_unexpected_error;
     }
-    uint64_t count = 0;
-
-    for (uint32_t i = 0; i < evm_outs.n_outs; i++) {
-        CHECK_ERROR(readBytes(out_ctx, address, ADDRESS_LEN));
-        CHECK_ERROR(read_u64(out_ctx, amount));
-        CHECK_ERROR(verifyBytes(out_ctx, ASSET_ID_LEN));
+    MEMZERO(groups, sizeof(*groups));
+
+    // Locktime, threshold, address count and addresses are contiguous in a secp output record,
+    // so two outputs pay the same destination when those bytes match
+    uint8_t n_shown = 0;
+    uint8_t n_groups = 0;
+    for (uint8_t k = 0; k < index->n_outputs && index->first_item[k] < index->n_shown_items; k++) {
+        n_shown++;
+        const uint8_t items = output_index_items(index, k);
+        const uint8_t *key = ctx->buffer + output_locktime_offset(index, k);
+        const uint16_t key_len = (uint16_t)(LOCKTIME_LEN + THRESHOLD_LEN + sizeof(uint32_t) + (items - 1) * ADDRESS_LEN);
+        const uint64_t amount = codec_read_be64(ctx->buffer + index->amount[k]);
+
+        uint8_t g = 0;
+        for (; g < n_groups; g++) {
+            const uint8_t rep = groups->output[g];
+            if (output_index_items(index, rep) != items) {
+                continue;
+            }
+            if (MEMCMP(key, ctx->buffer + output_locktime_offset(index, rep), key_len) == 0) {
+                break;
+            }
+        }
 
-        if (count == out_index) {
-            return parser_ok;
+        if (g == n_groups) {
+            if (n_groups == OUTPUT_GROUPS_MAX) {
+                // Too many destinations to summarize, list the outputs instead
+                MEMZERO(groups, sizeof(*groups));
+                return parser_ok;
+            }
+            groups->output[g] = k;
+            n_groups++;
         }
-        count++;
+        if (groups->amount[g] + amount < amount) {
+            MEMZERO(groups, sizeof(*groups));
+            return parser_unexpected_value;
+        }
+        groups->amount[g] += amount;
+    }
+
+    // Grouping only pays off when some outputs share a destination
+    if (n_groups == n_shown) {
+        MEMZERO(groups, sizeof(*groups));
+        return parser_ok;
     }
-    return parser_unexpected_number_items;
+    groups->n_groups = n_groups;
+    return parser_ok;
 }
 
 int parser_get_renderable_outputs_number(uint64_t mask) {
@@ -24,28 +24,44 @@ parser_error_t read_u16(parser_context_t *ctx, uint16_t *result);
 parser_error_t read_u8(parser_context_t *ctx, uint8_t *result);
 parser_error_t read_u32(parser_context_t *ctx, uint32_t *result);
 parser_error_t read_u64(parser_context_t *ctx, uint64_t *result);
+// Reads a uint32 list length, rejecting anything above max
+parser_error_t read_count(parser_context_t *ctx, uint8_t max, uint8_t *result);
 parser_error_t verifyBytes(parser_context_t *ctx, uint16_t buffLen);
 parser_error_t readBytes(parser_context_t *ctx, uint8_t *buff, uint16_t buffLen);
 parser_error_t checkAvailableBytes(parser_context_t *ctx, uint16_t buffLen);
 parser_error_t verifyContext(parser_context_t *ctx);
 
 parser_error_t parser_get_chain_id(parser_context_t *c, parser_tx_t *v);
-parser_error_t parser_get_chain_alias(const uint8_t *blockchain_id, char *chain);
-parser_error_t parser_go_to_next_transferable_output(parser_context_t *c);
+parser_error_t parser_get_chain_alias(network_id_e network, const uint8_t *blockchain_id, char *chain);
 
-parser_error_t parse_evm_inputs(parser_context_t *c, evm_inputs_t *evm);
-parser_error_t parse_transferable_secp_output(parser_context_t *c, transferable_out_secp_t *outputs, bool verify_locktime);
-parser_error_t parse_transferable_secp_input(parser_context_t *c, transferable_in_secp_t *outputs);
+// Chunked parsing: mark the bytes parsed so far as final and move to the
+// next layout step, or to the next record of the current list step.
+void parser_stream_next_step(parser_context_t *c, uint8_t step);
+void parser_stream_next_item(parser_context_t *c);
+
+// Single record parsers. They only update the aggregate once the whole
+// record has been read, so a record cut by the end of a chunk can be retried.
+parser_error_t parse_evm_input_record(parser_context_t *c, evm_inputs_t *evm);
+parser_error_t parse_transferable_secp_output_record(parser_context_t *c, transferable_out_secp_t *outputs,
+                                                     bool verify_locktime, output_index_t *index);
+parser_error_t parse_transferable_secp_input_record(parser_context_t *c, transferable_in_secp_t *inputs);
+parser_error_t parse_evm_output_record(parser_context_t *c, evm_outs_t *outputs, output_index_t *index);
 parser_error_t parse_secp_owners_output(parser_context_t *c, secp_owners_out_t *outputs);
-parser_error_t parse_evm_output(parser_context_t *c, evm_outs_t *outputs);
 
-parser_error_t parser_get_secp_output_for_index(parser_context_t *out_ctx, transferable_out_secp_t secp_outs,
-                                                uint8_t inner_displayIdx, uint64_t *amount, uint8_t *address,
-                                                uint8_t *element_idx);
+// Resolves a rendered output item through the index built while parsing.
+// element_idx is 0 for an amount and 1 for an address.
+parser_error_t parser_get_output_item(const parser_context_t *ctx, uint8_t item_idx, uint64_t *amount, uint8_t *address,
+                                      uint8_t *element_idx);
+
+// Moves the secp outputs paying change_address behind the others and sets n_shown_items to the
+// items before them. Without a change address every output is shown.
+parser_error_t parser_hide_change_outputs(const parser_context_t *ctx, output_index_t *index, const uint8_t *change_address);
 
-parser_error_t parser_get_evm_output_index(parser_context_t *out_ctx, evm_outs_t evm_outs, uint8_t out_index,
-                                           uint64_t *amount, uint8_t *address);
+// Sums the shown secp outputs per destination: same locktime, threshold and addresses.
+// Leaves groups->n_groups at 0 when no two outputs share a destination or there are too many.
+parser_error_t parser_group_outputs(const parser_context_t *ctx, const output_index_t *index, output_groups_t *groups);
 
+// Outputs set in a mask of renderable outputs
 int parser_get_renderable_outputs_number(uint64_t mask);
 #ifdef __cplusplus
 }
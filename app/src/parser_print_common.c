@@ -15,10 +15,10 @@
  ********************************************************************************/
 #include "parser_print_common.h"
 
-#include "base58.h"
-#include "bech32.h"
+#include "bech32_address.h"
+#include "crypto_helper.h"
+#include "networks.h"
 #include "parser_common.h"
-#include "timeutils.h"
 #include "zxformat.h"
 #include "zxmacros.h"
 
@@ -30,67 +30,132 @@
 #define CX_RIPEMD160_SIZE 20
 #endif
 
-void remove_fraction(char *s) {
-    size_t len = strlen(s);
+// Two ASCII digits for every value below 100
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
 
-    // Find the decimal point
-    char *decimal_point = strchr(s, '.');
-    if (decimal_point == NULL) {
-        // No decimal point found, nothing to remove
+static const uint64_t pow10_table[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+                                       100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+                                       10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                                       100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL};
+
+uint8_t count_u64_digits(uint64_t value) {
+    uint8_t digits = 1;
+    while (digits < sizeof(pow10_table) / sizeof(pow10_table[0]) && value >= pow10_table[digits]) {
+        digits++;
+    }
+    return digits;
+}
+
+void write_u64_digits(char *end, uint64_t value, uint8_t n_digits) {
+    char *p = end;
+    // Stay on 64-bit divisions only while the value needs them
+    while (value > UINT32_MAX) {
+        const uint32_t pair = (uint32_t)(value % 100);
+        value /= 100;
+        p -= 2;
+        MEMCPY(p, &digit_pairs[2 * pair], 2);
+    }
+    uint32_t low = (uint32_t)value;
+    while (end - p + 1 < n_digits) {
+        const uint32_t pair = low % 100;
+        low /= 100;
+        p -= 2;
+        MEMCPY(p, &digit_pairs[2 * pair], 2);
+    }
+    if (end - p < n_digits) {
+        *--p = (char)('0' + low % 10);
+    }
+}
+
+void writer_init(writer_t *w, char *buf, uint16_t len) {
+    w->buf = buf;
+    w->len = len;
+    w->pos = 0;
+    w->overflow = (buf == NULL || len == 0);
+    if (!w->overflow) {
+        buf[0] = '\0';
+    }
+}
+
+static void writer_append(writer_t *w, const char *data, uint16_t dataLen) {
+    if (w->overflow) {
         return;
     }
+    const uint16_t room = w->len - 1 - w->pos;
+    if (dataLen > room) {
+        dataLen = room;
+        w->overflow = true;
+    }
+    MEMCPY(w->buf + w->pos, data, dataLen);
+    w->pos += dataLen;
+    w->buf[w->pos] = '\0';
+}
+
+void writer_append_str(writer_t *w, const char *str) { writer_append(w, str, (uint16_t)strlen(str)); }
+
+void writer_append_char(writer_t *w, char c) { writer_append(w, &c, 1); }
 
-    // Find the end of the string up to the decimal point
-    size_t end_index = decimal_point - s;
+void writer_append_u64(writer_t *w, uint64_t value) {
+    char digits[20];
+    const uint8_t n_digits = count_u64_digits(value);
+    write_u64_digits(digits + n_digits, value, n_digits);
+    writer_append(w, digits, n_digits);
+}
 
-    // Find the first non-zero digit after the decimal point
-    size_t non_zero_index = end_index + 1;
-    while (s[non_zero_index] == '0') {
-        non_zero_index++;
+void writer_append_hex(writer_t *w, const uint8_t *data, uint16_t dataLen) {
+    const char *hex = (const char *)PIC("0123456789abcdef");
+    for (uint16_t i = 0; i < dataLen; i++) {
+        const char pair[2] = {hex[data[i] >> 4], hex[data[i] & 0x0F]};
+        writer_append(w, pair, sizeof(pair));
     }
+}
 
-    // Check if there is a non-zero digit after the decimal point
-    if (non_zero_index >= len) {
-        // There is no non-zero digit after the decimal point
-        // Remove the decimal point and trailing zeros
-        s[end_index] = '\0';
+void write_str(char *out, uint16_t outLen, const char *str) {
+    if (out == NULL || outLen == 0) {
+        return;
     }
+    const size_t len = strnlen(str, outLen - 1);
+    MEMCPY(out, str, len);
+    out[len] = '\0';
 }
 
 parser_error_t printAmount64(uint64_t amount, uint8_t amountDenom, network_id_e network_id, char *outVal, uint16_t outValLen,
                              uint8_t pageIdx, uint8_t *pageCount) {
-    char strAmount[33] = {0};
-    if (uint64_to_str(strAmount, sizeof(strAmount), amount) != NULL) {
+    const network_info_t *network = network_get(network_id);
+    if (network == NULL || amountDenom >= sizeof(pow10_table) / sizeof(pow10_table[0])) {
         return parser_unexpected_error;
     }
-    if (intstr_to_fpstr_inplace(strAmount, sizeof(strAmount), amountDenom) == 0) {
+
+    // Whole units, then the fraction without its trailing zeros
+    const uint64_t scale = pow10_table[amountDenom];
+    const uint64_t whole = amount / scale;
+    uint64_t fraction = amount % scale;
+    uint8_t fraction_digits = fraction == 0 ? 0 : amountDenom;
+    while (fraction != 0 && fraction % 10 == 0) {
+        fraction /= 10;
+        fraction_digits--;
+    }
+
+    // "<whole>[.<fraction>] <ticker>"
+    char strAmount[33] = {0};
+    const uint8_t whole_digits = count_u64_digits(whole);
+    const size_t ticker_len = strnlen(network->ticker, sizeof(network->ticker));
+    size_t len = whole_digits + (fraction_digits > 0 ? 1U + fraction_digits : 0U);
+    if (len + 1 + ticker_len >= sizeof(strAmount)) {
         return parser_unexpected_error;
     }
 
-    const char *symbol = NULL;
-    switch (network_id) {
-        case songbird:
-            symbol = " SGB";
-            break;
-        case coston:
-            symbol = " CFLR";
-            break;
-        case coston2:
-            symbol = " C2FLR";
-            break;
-        case mainnet:
-            symbol = " FLR";
-            break;
-        default:
-            return parser_unexpected_error;
-            break;
+    write_u64_digits(strAmount + whole_digits, whole, whole_digits);
+    if (fraction_digits > 0) {
+        strAmount[whole_digits] = '.';
+        write_u64_digits(strAmount + len, fraction, fraction_digits);
     }
+    strAmount[len++] = ' ';
+    MEMCPY(strAmount + len, network->ticker, ticker_len);
 
-    number_inplace_trimming(strAmount, 1);
-    remove_fraction(strAmount);
-    z_str3join(strAmount, sizeof(strAmount), "", symbol);
     pageString(outVal, outValLen, strAmount, pageIdx, pageCount);
-
     return parser_ok;
 }
 
@@ -100,29 +165,18 @@ parser_error_t printAddress(const uint8_t *pubkey, network_id_e network_id, char
         return parser_unexpected_error;
     }
 
-    const char *hrp = NULL;
-    switch (network_id) {
-        case songbird:
-            hrp = "song";
-            break;
-        case coston:
-            hrp = "coston";
-            break;
-        case coston2:
-            hrp = "costwo";
-            break;
-        case mainnet:
-            hrp = "flare";
-            break;
-        default:
-            return parser_unexpected_error;
-            break;
+    const network_info_t *network = network_get(network_id);
+    if (network == NULL) {
+        return parser_unexpected_error;
     }
-    char address[100] = {0};
+
+    char address[BECH32_ADDRESS_STR_LEN(NETWORK_HRP_LEN) + 1] = {0};
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
     const zxerr_t err = zxerr_ok;  // Bypass bech32 encoding
 #else
-    const zxerr_t err = bech32EncodeFromBytes(address, sizeof(address), hrp, pubkey, ADDRESS_LEN, 1, BECH32_ENCODING_BECH32);
+    const uint8_t hrp_len = (uint8_t)strnlen(network->hrp, NETWORK_HRP_LEN);
+    const zxerr_t err =
+        bech32_encode_address(address, sizeof(address), network->hrp, hrp_len, network->hrp_state, pubkey);
 #endif
 
     if (err != zxerr_ok) {
@@ -133,28 +187,120 @@ parser_error_t printAddress(const uint8_t *pubkey, network_id_e network_id, char
     return parser_ok;
 }
 
-parser_error_t printTimestamp(uint64_t timestamp, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    timedata_t date = {0};
+static inline void write_2digits(char *p, uint32_t value) { MEMCPY(p, &digit_pairs[2 * value], 2); }
 
-    if (extractTime(timestamp, &date) != zxerr_ok) {
-        return parser_unexpected_error;
+parser_error_t formatTimestamp(uint64_t timestamp, char *out, uint16_t outLen) {
+    if (out == NULL || outLen < TIMESTAMP_STR_LEN + 1) {
+        return parser_unexpected_buffer_end;
+    }
+    if (timestamp > TIMESTAMP_MAX) {
+        return parser_invalid_time_stamp;
     }
 
-    char time_str[30] = {0};
-    snprintf(time_str, 30, "%04d-%02d-%02d %02d:%02d:%02d UTC", date.tm_year, date.tm_mon, date.tm_day, date.tm_hour,
-             date.tm_min, date.tm_sec);
+    const uint32_t days = (uint32_t)(timestamp / 86400);
+    const uint32_t secs = (uint32_t)(timestamp % 86400);
+
+    // Civil date of a day count, with years starting on March 1st so the leap day comes last
+    const uint32_t z = days + 719468;
+    const uint32_t era = z / 146097;
+    const uint32_t doe = z - era * 146097;
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    const uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+    const uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    const uint32_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    // YYYY-MM-DD HH:MM:SS UTC
+    write_2digits(out, year / 100);
+    write_2digits(out + 2, year % 100);
+    out[4] = '-';
+    write_2digits(out + 5, month);
+    out[7] = '-';
+    write_2digits(out + 8, day);
+    out[10] = ' ';
+    write_2digits(out + 11, secs / 3600);
+    out[13] = ':';
+    write_2digits(out + 14, (secs / 60) % 60);
+    out[16] = ':';
+    write_2digits(out + 17, secs % 60);
+    MEMCPY(out + 19, " UTC", 5);
+
+    return parser_ok;
+}
+
+parser_error_t printTimestamp(uint64_t timestamp, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    char time_str[TIMESTAMP_STR_LEN + 1];
+    if (formatTimestamp(timestamp, time_str, sizeof(time_str)) != parser_ok) {
+        return parser_unexpected_error;
+    }
 
     pageString(outVal, outValLen, time_str, pageIdx, pageCount);
 
     return parser_ok;
 }
 
-parser_error_t printNodeId(const uint8_t *nodeId, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    if (nodeId == NULL) {
+// 58^5 is the largest power of 58 that fits a 32-bit limb
+#define BASE58_POW5 656356768U
+#define BASE58_DIGITS_PER_PASS 5
+#define NODE_ID_PAYLOAD_LIMBS (NODE_ID_PAYLOAD_LEN / sizeof(uint32_t))
+#define NODE_ID_BASE58_PASSES ((NODE_ID_BASE58_MAX_LEN + BASE58_DIGITS_PER_PASS - 1) / BASE58_DIGITS_PER_PASS)
+#define NODE_ID_BASE58_DIGITS (NODE_ID_BASE58_PASSES * BASE58_DIGITS_PER_PASS)
+
+static const char base58_alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+uint8_t encode_base58_node_id(const uint8_t *in, char *out) {
+    uint32_t limbs[NODE_ID_PAYLOAD_LIMBS];
+    for (uint8_t i = 0; i < NODE_ID_PAYLOAD_LIMBS; i++) {
+        const uint8_t *p = in + i * sizeof(uint32_t);
+        limbs[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    // Every pass divides the whole number by 58^5 and yields its 5 lowest digits
+    uint8_t digits[NODE_ID_BASE58_DIGITS];
+    for (uint8_t pass = 0; pass < NODE_ID_BASE58_PASSES; pass++) {
+        uint64_t rem = 0;
+        for (uint8_t i = 0; i < NODE_ID_PAYLOAD_LIMBS; i++) {
+            const uint64_t cur = (rem << 32) | limbs[i];
+            limbs[i] = (uint32_t)(cur / BASE58_POW5);
+            rem = cur % BASE58_POW5;
+        }
+        uint32_t chunk = (uint32_t)rem;
+        uint8_t *d = digits + NODE_ID_BASE58_DIGITS - (pass + 1) * BASE58_DIGITS_PER_PASS;
+        for (uint8_t j = BASE58_DIGITS_PER_PASS; j > 0; j--) {
+            d[j - 1] = (uint8_t)(chunk % 58);
+            chunk /= 58;
+        }
+    }
+
+    // Leading zero bytes are kept as '1's, leading zero digits are dropped
+    uint8_t zeros = 0;
+    while (zeros < NODE_ID_PAYLOAD_LEN && in[zeros] == 0) {
+        zeros++;
+    }
+    uint8_t first = 0;
+    while (first < NODE_ID_BASE58_DIGITS && digits[first] == 0) {
+        first++;
+    }
+
+    const char *alphabet = (const char *)PIC(base58_alphabet);
+    uint8_t len = 0;
+    for (; len < zeros; len++) {
+        out[len] = '1';
+    }
+    for (uint8_t i = first; i < NODE_ID_BASE58_DIGITS; i++) {
+        out[len++] = alphabet[digits[i]];
+    }
+    out[len] = '\0';
+    return len;
+}
+
+parser_error_t encodeNodeId(const uint8_t *nodeId, char *out, uint16_t outLen) {
+    if (nodeId == NULL || out == NULL || outLen < NODE_ID_MAX_SIZE) {
         return parser_unexpected_error;
     }
 
-    char data[NODE_ID_LEN + CB58_CHECKSUM_LEN] = {0};
+    uint8_t data[NODE_ID_PAYLOAD_LEN] = {0};
 
     // Copy node_id to data
     MEMCPY(data, nodeId, NODE_ID_LEN);
@@ -188,33 +334,27 @@ parser_error_t printNodeId(const uint8_t *nodeId, char *outVal, uint16_t outValL
 
     // Prefix for node_id
     const char prefix[] = "NodeID-";
-
-    // Prepare node_id by appending prefix
-    uint8_t node_id[NODE_ID_MAX_SIZE] = {0};
-    size_t outlen = sizeof(node_id) - sizeof(prefix) + 1;
-    memcpy(node_id, prefix, sizeof(prefix) - 1);
-
-    CHECK_ERROR(encode_base58((const unsigned char *)data, sizeof(data), node_id + sizeof(prefix) - 1, &outlen))
-    pageString(outVal, outValLen, (const char *)node_id, pageIdx, pageCount);
+    MEMCPY(out, prefix, sizeof(prefix) - 1);
+    encode_base58_node_id(data, out + sizeof(prefix) - 1);
 
     return parser_ok;
 }
 
 parser_error_t printHash(const parser_context_t *ctx, char *outVal, uint16_t outValLen, uint8_t pageIdx,
                          uint8_t *pageCount) {
-    unsigned char hash[CX_SHA256_SIZE] = {0};
+    if (ctx == NULL || ctx->tx_obj == NULL) {
+        return parser_unexpected_error;
+    }
 
-#if defined(LEDGER_SPECIFIC)
-    cx_sha256_t hash_ctx;
-    memset(&hash_ctx, 0, sizeof(hash_ctx));
-    CHECK_CX_PARSER_OK(cx_sha256_init_no_throw(&hash_ctx));
-    CHECK_CX_PARSER_OK(cx_hash_no_throw(&hash_ctx.header, CX_LAST, ctx->buffer, ctx->bufferLen, hash, sizeof(hash)));
-#else
-    picohash_ctx_t hash_ctx;
-    picohash_init_sha256(&hash_ctx);
-    picohash_update(&hash_ctx, ctx->buffer, ctx->bufferLen);
-    picohash_final(&hash_ctx, &hash);
-#endif
-    pageStringHex(outVal, outValLen, (const char *)hash, sizeof(hash), pageIdx, pageCount);
+    // Hash the tx only if the tx layer did not provide its digest
+    if (!ctx->tx_obj->tx_hash_ready) {
+        if (crypto_sha256(ctx->buffer, ctx->bufferLen, ctx->tx_obj->tx_hash, sizeof(ctx->tx_obj->tx_hash)) != zxerr_ok) {
+            return parser_unexpected_error;
+        }
+        ctx->tx_obj->tx_hash_ready = true;
+    }
+
+    pageStringHex(outVal, outValLen, (const char *)ctx->tx_obj->tx_hash, sizeof(ctx->tx_obj->tx_hash), pageIdx,
+                  pageCount);
     return parser_ok;
 }
\ No newline at end of file
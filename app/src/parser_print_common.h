@@ -28,14 +28,53 @@ extern "C" {
         }                                   \
     } while (0)
 
+// Bounded writer over a display buffer. Appends stop at len - 1 and keep the text terminated,
+// truncating like snprintf would. Once something is cut, overflow is set and later appends are dropped.
+typedef struct {
+    char *buf;
+    uint16_t len;
+    uint16_t pos;
+    bool overflow;
+} writer_t;
+
+void writer_init(writer_t *w, char *buf, uint16_t len);
+void writer_append_str(writer_t *w, const char *str);
+void writer_append_char(writer_t *w, char c);
+void writer_append_u64(writer_t *w, uint64_t value);
+void writer_append_hex(writer_t *w, const uint8_t *data, uint16_t dataLen);
+
+// Replaces out with str, the usual way of setting a key or a fixed value
+void write_str(char *out, uint16_t outLen, const char *str);
+
+// Decimal digits of value, at least 1
+uint8_t count_u64_digits(uint64_t value);
+// Writes the n_digits last decimal digits of value, zero padded, so that they end right before end
+void write_u64_digits(char *end, uint64_t value, uint8_t n_digits);
+
 parser_error_t printAmount64(uint64_t amount, uint8_t amountDenom, network_id_e network_id, char *outVal, uint16_t outValLen,
                              uint8_t pageIdx, uint8_t *pageCount);
 parser_error_t printAddress(const uint8_t *pubkey, network_id_e network_id, char *outVal, uint16_t outValLen,
                             uint8_t pageIdx, uint8_t *pageCount);
 
+// "YYYY-MM-DD HH:MM:SS UTC", up to the last second with a four digit year
+#define TIMESTAMP_STR_LEN 23
+#define TIMESTAMP_MAX 253402300799ULL
+
+// Writes the UTC date of a unix timestamp into out, which takes TIMESTAMP_STR_LEN + 1 bytes
+parser_error_t formatTimestamp(uint64_t timestamp, char *out, uint16_t outLen);
+
 parser_error_t printTimestamp(uint64_t timestamp, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
 
-parser_error_t printNodeId(const uint8_t *nodeId, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
+// CB58 payload of a node id: its NODE_ID_LEN bytes and the checksum, at most 33 base58 digits
+#define NODE_ID_PAYLOAD_LEN (NODE_ID_LEN + CB58_CHECKSUM_LEN)
+#define NODE_ID_BASE58_MAX_LEN 33
+
+// Base58 of exactly NODE_ID_PAYLOAD_LEN bytes, same digits as encode_base58. out takes
+// NODE_ID_BASE58_MAX_LEN characters and the terminator, the length written is returned.
+uint8_t encode_base58_node_id(const uint8_t *in, char *out);
+
+// "NodeID-" followed by the CB58 of nodeId, out takes NODE_ID_MAX_SIZE bytes
+parser_error_t encodeNodeId(const uint8_t *nodeId, char *out, uint16_t outLen);
 
 parser_error_t printHash(const parser_context_t *ctx, char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
 
@@ -19,6 +19,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -30,6 +31,7 @@ extern "C" {
 #define NODE_ID_MAX_SIZE 41
 #define CB58_CHECKSUM_LEN 4
 #define TX_ID_LEN 32
+#define TX_HASH_LEN 32
 #define ADDRESS_LEN 20
 #define TYPE_ID_LEN 4
 #define LOCKTIME_LEN 8
@@ -63,6 +65,9 @@ extern "C" {
 #define MAX_OUTPUTS 64
 #define MAX_INPUTS 64
 #define MAX_MEMO_SIZE 256
+// Upper bound of Amount/Address items for the rendered output set: MAX_OUTPUTS
+// amounts plus the (UINT8_MAX - MAX_OUTPUTS - 3) addresses accepted by the parser.
+#define MAX_OUTPUT_ITEMS (UINT8_MAX - 3)
 
 #define AMOUNT_DECIMAL_PLACES 9
 
@@ -88,94 +93,108 @@ typedef enum {
     base_tx,
 } tx_type_e;
 
+// Transactions body structures. Fields pointing into the tx are kept as
+// 16-bit offsets into the parsed buffer (see parser_tx_field); list counts
+// are capped at MAX_INPUTS/MAX_OUTPUTS and fit in 8 bits.
 typedef struct {
-    uint8_t blockchain_id[BLOCKCHAIN_ID_LEN];
-    chain_id_e chain;
-    char name;
-} chain_lookup_table_t;
-
-// Transactions body structures
-typedef struct {
-    uint32_t n_ins;
-    const uint8_t *ins;
-    uint16_t ins_offset;
+    uint8_t n_ins;
     uint64_t in_sum;
 } transferable_in_secp_t;
 
 typedef struct {
-    uint32_t n_outs;
-    const uint8_t *outs;
-    uint16_t outs_offset;
+    uint8_t n_outs;
+    uint8_t n_addrs;
     uint64_t out_sum;
-    uint32_t n_addrs;
 } transferable_out_secp_t;
 
 typedef struct {
-    uint32_t n_outs;
-    const uint8_t *outs;
-    uint32_t n_addr;
-    const uint8_t *addr;
+    uint8_t n_outs;
+    uint8_t n_addr;
+    uint16_t addr;
 } secp_owners_out_t;
 
 typedef struct {
-    uint32_t n_ins;
-    const uint8_t *ins;
+    uint8_t n_ins;
     uint64_t in_sum;
-
-    const uint8_t *addr;
-    const uint8_t *amount;
-    const uint8_t *asset_id;
-    uint64_t nonce;
 } evm_inputs_t;
 
 typedef struct {
-    uint32_t n_outs;
-    const uint8_t *outs;
-    uint16_t outs_offset;
+    uint8_t n_outs;
     uint64_t out_sum;
 } evm_outs_t;
 
+// Index of the output set shown in the review, filled while the outputs are
+// parsed so display lookups do not rescan the records. Output k renders its
+// amount as item first_item[k], followed by its addresses; the addresses sit
+// at a fixed distance from the amount for a given record layout.
+// Outputs paying the wallet's change address are moved behind the others
+// once parsing ends, so items from n_shown_items on are change.
+typedef struct {
+    uint8_t n_items;
+    uint8_t n_outputs;
+    int8_t address_delta;
+    uint8_t n_shown_items;
+    uint8_t first_item[MAX_OUTPUTS];
+    uint16_t amount[MAX_OUTPUTS];
+} output_index_t;
+
+// Shown outputs summed per spending condition: same locktime, threshold and
+// addresses. Group g is rendered as its total followed by the addresses of
+// its first output. n_groups stays 0 when grouping merges nothing or would
+// take more than OUTPUT_GROUPS_MAX groups; the outputs are listed one by one then.
+#define OUTPUT_GROUPS_MAX 8
+
+typedef struct {
+    uint8_t n_groups;
+    uint8_t output[OUTPUT_GROUPS_MAX];
+    uint64_t amount[OUTPUT_GROUPS_MAX];
+} output_groups_t;
+
 typedef struct {
     transferable_out_secp_t base_secp_outs;
     transferable_in_secp_t base_secp_ins;
-    const uint8_t *source_chain;
+    uint16_t source_chain;
     transferable_in_secp_t secp_ins;
 } p_import_tx_t;
 
 typedef struct {
     transferable_out_secp_t base_secp_outs;
     transferable_in_secp_t base_secp_ins;
-    const uint8_t *destination_chain;
+    uint16_t destination_chain;
     transferable_out_secp_t secp_outs;
 } p_export_tx_t;
 
 typedef struct {
-    const uint8_t *source_chain;
+    uint16_t source_chain;
     transferable_in_secp_t secp_inputs;
     evm_outs_t evm_outs;
 } c_import_tx_t;
 
 typedef struct {
-    const uint8_t *destination_chain;
+    uint16_t destination_chain;
     evm_inputs_t evm_inputs;
     transferable_out_secp_t secp_outs;
 } c_export_tx_t;
 
 #define EMPTY_SIGNER_TYPE_ID 0x1B
 #define PROOF_OF_POSSESSION_TYPE_ID 0x1C
+#define BLS_PUBLIC_KEY_LEN 48
+#define BLS_SIGNATURE_LEN 96
 
 typedef struct {
-    const uint8_t *public_key;
-    const uint8_t *signature;
+    uint16_t public_key;
+    uint16_t signature;
 } proof_of_possession_t;
 
 typedef struct {
-    uint32_t signer_type;
+    uint8_t signer_type;
     proof_of_possession_t proof_of_possession;
 } signer_t;
 
 typedef struct {
-    const uint8_t *node_id;
+    uint16_t node_id;
+    // "NodeID-..." string, encoded once when the validator is parsed
+    char node_id_str[NODE_ID_MAX_SIZE];
     uint64_t start_time;
     uint64_t end_time;
     uint64_t weight;
@@ -185,7 +204,7 @@ typedef struct {
     transferable_out_secp_t base_secp_outs;
     transferable_in_secp_t base_secp_ins;
     validator_t validator;
-    const uint8_t *subnet_id;
+    uint16_t subnet_id;
     signer_t signer;
     transferable_out_secp_t stake_outs;
     secp_owners_out_t validator_rewards_owner;
@@ -197,7 +216,7 @@ typedef struct {
     transferable_out_secp_t base_secp_outs;
     transferable_in_secp_t base_secp_ins;
     validator_t validator;
-    const uint8_t *subnet_id;
+    uint16_t subnet_id;
     transferable_out_secp_t stake_outs;
     secp_owners_out_t delegator_rewards_owner;
 } p_add_permissionless_delegator_tx_t;
@@ -217,19 +236,117 @@ typedef union tx_command {
     base_tx_t base_tx;
 } tx_t;
 
+// Amounts derived once the whole tx is parsed. total_out excludes the staked
+// outputs, so fee = total_in - total_out - staked.
+typedef struct {
+    uint64_t total_in;
+    uint64_t total_out;
+    uint64_t staked;
+    uint64_t fee;
+    // Outputs listed in the review, each with its amount and addresses
+    uint8_t n_outputs;
+} tx_summary_t;
+
+// Steps shared by every layout; the chain specific ones are numbered from
+// PARSER_STEP_BODY onwards.
+#define PARSER_STEP_HEADER 0
+#define PARSER_STEP_BODY 1
+#define PARSER_STEP_DONE 0xFF
+
+// Resume point of the chunked parser. Everything before offset is parsed
+// for good; step is the next layout step and, for list steps, item counts
+// the records already consumed.
 typedef struct {
-    tx_type_e tx_type;
-    network_id_e network_id;
-    const uint8_t *blockchain_id;
-    chain_id_e chain_id;
-    // Pointer to the first asset ID seen while parsing inputs/outputs.
+    uint16_t offset;
+    uint8_t step;
+    uint8_t item;
+} parser_stream_t;
+
+// Items of the review. Each tx type lists them in the order it shows them and
+// the list is compiled into a display plan once parsing ends.
+typedef enum {
+    display_send = 0,
+    display_p_export,
+    display_p_import,
+    display_c_export,
+    display_c_import,
+    display_outputs,         // amount and addresses of every rendered output
+    display_output_groups,   // the same outputs summed per destination, shown instead outside expert mode
+    display_change_outputs,  // outputs back to the wallet, only shown in expert mode
+    display_evm_outputs,     // same as display_outputs for C-chain imports, paid to EVM addresses
+    display_node_id,
+    display_start_time,
+    display_end_time,
+    display_total_stake,
+    display_rewards_to,
+    display_delegate_fee,
+    display_fee,
+    display_hash,  // closes every plan, only shown in expert mode
+} display_kind_e;
+
+#define DISPLAY_PLAN_MAX_ENTRIES 8
+
+// Views of the plan: outside and in expert mode
+#define DISPLAY_VIEW_NORMAL 0
+#define DISPLAY_VIEW_EXPERT 1
+#define DISPLAY_VIEWS 2
+
+// count is the number of display items the entry spans: one per output item
+// for the output set, one for everything else.
+typedef struct {
+    uint8_t kind;
+    uint8_t count;
+} display_entry_t;
+
+typedef struct {
+    uint8_t n_entries;
+    // Items shown in each view
+    uint8_t n_items[DISPLAY_VIEWS];
+    display_entry_t entries[DISPLAY_PLAN_MAX_ENTRIES];
+} display_plan_t;
+
+// Offset 0 holds the codec version, so no parsed field ever starts there
+#define PARSER_TX_NO_OFFSET 0
+
+typedef struct {
+    // tx_type_e, network_id_e and chain_id_e
+    uint8_t tx_type : 3;
+    uint8_t network_id : 2;
+    uint8_t chain_id : 1;
+    uint8_t tx_hash_ready : 1;
+    uint16_t blockchain_id;
+    // Offset of the first asset ID seen while parsing inputs/outputs.
     // Used to enforce that every input/output in the transaction carries
     // the same asset ID (the network's native asset), since the display
     // layer labels all amounts with the network-native symbol.
-    const uint8_t *expected_asset_id;
+    uint16_t expected_asset_id;
     tx_t tx;
+    tx_summary_t summary;
+    output_index_t out_index;
+    output_groups_t out_groups;
+    parser_stream_t stream;
+    display_plan_t display;
+    // SHA-256 of the whole tx, computed once per parsed tx and shown by the Hash item
+    uint8_t tx_hash[TX_HASH_LEN];
 } parser_tx_t;
 
+// RAM budget of the parsed tx, per target. The layout holds no pointers, so
+// every build agrees on its size and the host tests check both budgets.
+// NanoX (ZXLIB_LIGHT_MODE) is held to the current size: its item cache lives
+// in the RAM the offset layout freed. The other targets keep the 848 bytes
+// the pointer layout used to take. Staking txs carry their encoded NodeID,
+// which sets the current size, and every tx its display plan and output groups.
+// Raising a budget needs a justification in the commit doing it: the
+// measured size and what the extra bytes buy.
+#define PARSER_TX_MAX_SIZE_LIGHT 528
+#define PARSER_TX_MAX_SIZE_FULL 848
+
+#if defined(ZXLIB_LIGHT_MODE)
+#define PARSER_TX_MAX_SIZE PARSER_TX_MAX_SIZE_LIGHT
+#else
+#define PARSER_TX_MAX_SIZE PARSER_TX_MAX_SIZE_FULL
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,79 +17,114 @@
 
 #include "common/parser_common.h"
 #include "parser_impl_common.h"
-#include "parser_print_common.h"
-#include "zxformat.h"
 #include "zxmacros.h"
 
+// C-chain atomic layout steps, resumed by the chunked parser
+typedef enum {
+    step_chain = PARSER_STEP_BODY,
+    step_ins_count,
+    step_ins,
+    step_outs_count,
+    step_outs,
+} cchain_step_e;
+
 static parser_error_t parser_handle_cchain_export(parser_context_t *c, parser_tx_t *v) {
-    // Get destination chain
-    CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
-    v->tx.c_export_tx.destination_chain = c->buffer + c->offset;
-    if (!MEMCMP(v->tx.c_export_tx.destination_chain, v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
-        return parser_unexpected_chain;
+    if (v->stream.step == step_chain) {
+        // Get destination chain
+        CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
+        v->tx.c_export_tx.destination_chain = c->offset;
+        if (!MEMCMP(c->buffer + c->offset, c->buffer + v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
+            return parser_unexpected_chain;
+        }
+        CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
+        parser_stream_next_step(c, step_ins_count);
     }
-    CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
 
-    // Get number of inputs
-    CHECK_ERROR(read_u32(c, &v->tx.c_export_tx.evm_inputs.n_ins));
-    if (v->tx.c_export_tx.evm_inputs.n_ins > MAX_INPUTS || v->tx.c_export_tx.evm_inputs.n_ins == 0) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_ins_count) {
+        // Get number of inputs
+        CHECK_ERROR(read_count(c, MAX_INPUTS, &v->tx.c_export_tx.evm_inputs.n_ins));
+        if (v->tx.c_export_tx.evm_inputs.n_ins == 0) {
+            return parser_unexpected_number_items;
+        }
+        CHECK_ERROR(verifyContext(c));
+        v->tx.c_export_tx.evm_inputs.in_sum = 0;
+        parser_stream_next_step(c, step_ins);
     }
 
-    // Pointer to inputs
-    CHECK_ERROR(verifyContext(c));
-    v->tx.c_export_tx.evm_inputs.ins = c->buffer + c->offset;
-    CHECK_ERROR(parse_evm_inputs(c, &v->tx.c_export_tx.evm_inputs));
+    if (v->stream.step == step_ins) {
+        while (v->stream.item < v->tx.c_export_tx.evm_inputs.n_ins) {
+            CHECK_ERROR(parse_evm_input_record(c, &v->tx.c_export_tx.evm_inputs));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, step_outs_count);
+    }
 
-    // Get number of outputs
-    CHECK_ERROR(read_u32(c, &v->tx.c_export_tx.secp_outs.n_outs));
-    if (v->tx.c_export_tx.secp_outs.n_outs > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_outs_count) {
+        // Get number of outputs
+        CHECK_ERROR(read_count(c, MAX_OUTPUTS, &v->tx.c_export_tx.secp_outs.n_outs));
+        if (v->tx.c_export_tx.secp_outs.n_outs > 0) {
+            CHECK_ERROR(verifyContext(c));
+        }
+        v->tx.c_export_tx.secp_outs.out_sum = 0;
+        v->tx.c_export_tx.secp_outs.n_addrs = 0;
+        parser_stream_next_step(c, step_outs);
     }
 
-    // Pointer to outputs
-    if (v->tx.c_export_tx.secp_outs.n_outs > 0) {
-        CHECK_ERROR(verifyContext(c));
-        v->tx.c_export_tx.secp_outs.outs = c->buffer + c->offset;
-        v->tx.c_export_tx.secp_outs.outs_offset = c->offset;
-        CHECK_ERROR(parse_transferable_secp_output(c, &v->tx.c_export_tx.secp_outs, false));
+    if (v->stream.step == step_outs) {
+        while (v->stream.item < v->tx.c_export_tx.secp_outs.n_outs) {
+            CHECK_ERROR(parse_transferable_secp_output_record(c, &v->tx.c_export_tx.secp_outs, false, &v->out_index));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, PARSER_STEP_DONE);
     }
 
     return parser_ok;
 }
 
 static parser_error_t parser_handle_cchain_import(parser_context_t *c, parser_tx_t *v) {
-    // Get source chain
-    CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
-    v->tx.c_import_tx.source_chain = c->buffer + c->offset;
-    if (!MEMCMP(v->tx.c_import_tx.source_chain, v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
-        return parser_unexpected_chain;
+    if (v->stream.step == step_chain) {
+        // Get source chain
+        CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
+        v->tx.c_import_tx.source_chain = c->offset;
+        if (!MEMCMP(c->buffer + c->offset, c->buffer + v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
+            return parser_unexpected_chain;
+        }
+        CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
+        parser_stream_next_step(c, step_ins_count);
     }
-    CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
 
-    // Get number of inputs
-    CHECK_ERROR(read_u32(c, &v->tx.c_import_tx.secp_inputs.n_ins));
-    if (v->tx.c_import_tx.secp_inputs.n_ins > MAX_INPUTS) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_ins_count) {
+        // Get number of inputs
+        CHECK_ERROR(read_count(c, MAX_INPUTS, &v->tx.c_import_tx.secp_inputs.n_ins));
+        CHECK_ERROR(verifyContext(c));
+        v->tx.c_import_tx.secp_inputs.in_sum = 0;
+        parser_stream_next_step(c, step_ins);
     }
 
-    // Pointer to inputs
-    CHECK_ERROR(verifyContext(c));
-    v->tx.c_import_tx.secp_inputs.ins = c->buffer + c->offset;
-    CHECK_ERROR(parse_transferable_secp_input(c, &v->tx.c_import_tx.secp_inputs));
+    if (v->stream.step == step_ins) {
+        while (v->stream.item < v->tx.c_import_tx.secp_inputs.n_ins) {
+            CHECK_ERROR(parse_transferable_secp_input_record(c, &v->tx.c_import_tx.secp_inputs));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, step_outs_count);
+    }
 
-    // Get number of outputs
-    CHECK_ERROR(read_u32(c, &v->tx.c_import_tx.evm_outs.n_outs));
-    if (v->tx.c_import_tx.evm_outs.n_outs > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_outs_count) {
+        // Get number of outputs
+        CHECK_ERROR(read_count(c, MAX_OUTPUTS, &v->tx.c_import_tx.evm_outs.n_outs));
+        if (v->tx.c_import_tx.evm_outs.n_outs > 0) {
+            CHECK_ERROR(verifyContext(c));
+        }
+        v->tx.c_import_tx.evm_outs.out_sum = 0;
+        parser_stream_next_step(c, step_outs);
     }
 
-    // Pointer to outputs
-    if (v->tx.c_import_tx.evm_outs.n_outs > 0) {
-        CHECK_ERROR(verifyContext(c));
-        v->tx.c_import_tx.evm_outs.outs = c->buffer + c->offset;
-        v->tx.c_import_tx.evm_outs.outs_offset = c->offset;
-        CHECK_ERROR(parse_evm_output(c, &v->tx.c_import_tx.evm_outs));
+    if (v->stream.step == step_outs) {
+        while (v->stream.item < v->tx.c_import_tx.evm_outs.n_outs) {
+            CHECK_ERROR(parse_evm_output_record(c, &v->tx.c_import_tx.evm_outs, &v->out_index));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, PARSER_STEP_DONE);
     }
 
     return parser_ok;
@@ -111,122 +146,46 @@ parser_error_t parser_cchain(parser_context_t *c, parser_tx_t *v) {
     return parser_ok;
 }
 
-parser_error_t print_c_export_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
-                                 char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    if (displayIdx == 0) {
-        snprintf(outKey, outKeyLen, "Export");
-        char chain = 0;
-        CHECK_ERROR(parser_get_chain_alias(ctx->tx_obj->tx.c_export_tx.destination_chain, &chain));
-        snprintf(outVal, outValLen, "C to %c chain", chain);
-        return parser_ok;
-    }
+parser_error_t parser_summary_cchain(parser_tx_t *v) {
+    tx_summary_t *summary = &v->summary;
+    MEMZERO(summary, sizeof(*summary));
 
-    // print ampount and addresses
-    if (displayIdx <= ctx->tx_obj->tx.c_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.c_export_tx.secp_outs.n_outs) {
-        parser_context_t output_ctx = {.buffer = ctx->tx_obj->tx.c_export_tx.secp_outs.outs,
-                                       .bufferLen = ctx->bufferLen - ctx->tx_obj->tx.c_export_tx.secp_outs.outs_offset + 1,
-                                       .offset = 0,
-                                       .tx_obj = NULL};
-
-        uint8_t inner_displayIdx = displayIdx - 1;
-        uint8_t element_idx = 0;
-        uint64_t amount = 0;
-        uint8_t address[ADDRESS_LEN] = {0};
-
-        // check which output cointains the displayIdx we want
-        CHECK_ERROR(parser_get_secp_output_for_index(&output_ctx, ctx->tx_obj->tx.c_export_tx.secp_outs, inner_displayIdx,
-                                                     &amount, address, &element_idx));
-        if (!element_idx) {
-            snprintf(outKey, outKeyLen, "Amount");
-            CHECK_ERROR(printAmount64(amount, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                      pageCount));
-        } else {
-            snprintf(outKey, outKeyLen, "Address");
-            CHECK_ERROR(printAddress(address, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        }
-        return parser_ok;
-    }
-
-    if (displayIdx == ctx->tx_obj->tx.c_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.c_export_tx.secp_outs.n_outs + 1) {
-        snprintf(outKey, outKeyLen, "Fee");
-        if (ctx->tx_obj->tx.c_export_tx.secp_outs.out_sum > ctx->tx_obj->tx.c_export_tx.evm_inputs.in_sum) {
-            // Prevent underflow
-            return parser_unexpected_value;
-        }
-        uint64_t fee = ctx->tx_obj->tx.c_export_tx.evm_inputs.in_sum - ctx->tx_obj->tx.c_export_tx.secp_outs.out_sum;
-        CHECK_ERROR(
-            printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        return parser_ok;
+    switch (v->tx_type) {
+        case c_export_tx:
+            summary->total_in = v->tx.c_export_tx.evm_inputs.in_sum;
+            summary->total_out = v->tx.c_export_tx.secp_outs.out_sum;
+            summary->n_outputs = v->tx.c_export_tx.secp_outs.n_outs;
+            break;
+        case c_import_tx:
+            summary->total_in = v->tx.c_import_tx.secp_inputs.in_sum;
+            summary->total_out = v->tx.c_import_tx.evm_outs.out_sum;
+            summary->n_outputs = v->tx.c_import_tx.evm_outs.n_outs;
+            break;
+        default:
+            return parser_unexpected_type;
     }
 
-    if (displayIdx == ctx->tx_obj->tx.c_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.c_export_tx.secp_outs.n_outs + 1 + 1) {
-        snprintf(outKey, outKeyLen, "Hash");
-        printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-        return parser_ok;
+    if (summary->total_out > summary->total_in) {
+        // Prevent underflow
+        return parser_unexpected_value;
     }
-
-    return parser_display_idx_out_of_range;
+    summary->fee = summary->total_in - summary->total_out;
+    return parser_ok;
 }
 
-parser_error_t print_c_import_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
-                                 char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    if (displayIdx == 0) {
-        snprintf(outKey, outKeyLen, "Import");
-        char chain = 0;
-        CHECK_ERROR(parser_get_chain_alias(ctx->tx_obj->tx.c_import_tx.source_chain, &chain));
-        snprintf(outVal, outValLen, "C from %c chain", chain);
-        return parser_ok;
-    }
+parser_error_t parser_validate_cchain(const parser_context_t *ctx) {
+    const parser_tx_t *v = ctx->tx_obj;
+    char chain = 0;
 
-    // print ampount and addresses
-    if (displayIdx <= 2 * (ctx->tx_obj->tx.c_import_tx.evm_outs.n_outs)) {
-        parser_context_t output_ctx = {.buffer = ctx->tx_obj->tx.c_import_tx.evm_outs.outs,
-                                       .bufferLen = ctx->bufferLen - ctx->tx_obj->tx.c_import_tx.evm_outs.outs_offset + 1,
-                                       .offset = 0,
-                                       .tx_obj = NULL};
-
-        // Get output index for
-        uint8_t out_index = (displayIdx - 1) / 2;
-        uint64_t amount = 0;
-        uint8_t address[ADDRESS_LEN] = {0};
-
-        // check which output cointains the displayIdx we want
-        CHECK_ERROR(
-            parser_get_evm_output_index(&output_ctx, ctx->tx_obj->tx.c_import_tx.evm_outs, out_index, &amount, address));
-        if ((displayIdx - 1) % 2 == 0) {
-            snprintf(outKey, outKeyLen, "Amount");
-            CHECK_ERROR(printAmount64(amount, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                      pageCount));
-        } else {
-            snprintf(outKey, outKeyLen, "Address");
-            char tmp_buffer[100] = {0};
-            tmp_buffer[0] = '0';
-            tmp_buffer[1] = 'x';
-            if (array_to_hexstr(tmp_buffer + 2, sizeof(tmp_buffer) - 2, address, ADDRESS_LEN) == 0) {
-                return parser_unexpected_data_len;
-            }
-            pageString(outVal, outValLen, tmp_buffer, pageIdx, pageCount);
-        }
-        return parser_ok;
-    }
+    // As on the P-chain, output items are read through the index built while parsing and need no check
+    switch (v->tx_type) {
+        case c_export_tx:
+            return parser_get_chain_alias(v->network_id, parser_tx_field(ctx, v->tx.c_export_tx.destination_chain), &chain);
 
-    if (displayIdx == (2 * ctx->tx_obj->tx.c_import_tx.evm_outs.n_outs) + 1) {
-        snprintf(outKey, outKeyLen, "Fee");
-        if (ctx->tx_obj->tx.c_import_tx.secp_inputs.in_sum < ctx->tx_obj->tx.c_import_tx.evm_outs.out_sum) {
-            // Prevent underflow
-            return parser_unexpected_value;
-        }
-        uint64_t fee = ctx->tx_obj->tx.c_import_tx.secp_inputs.in_sum - ctx->tx_obj->tx.c_import_tx.evm_outs.out_sum;
-        CHECK_ERROR(
-            printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        return parser_ok;
-    }
+        case c_import_tx:
+            return parser_get_chain_alias(v->network_id, parser_tx_field(ctx, v->tx.c_import_tx.source_chain), &chain);
 
-    if (displayIdx == (2 * ctx->tx_obj->tx.c_import_tx.evm_outs.n_outs) + 1 + 1) {
-        snprintf(outKey, outKeyLen, "Hash");
-        printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-        return parser_ok;
+        default:
+            return parser_unexpected_type;
     }
-
-    return parser_display_idx_out_of_range;
 }
@@ -21,10 +21,10 @@ extern "C" {
 #endif
 
 parser_error_t parser_cchain(parser_context_t *c, parser_tx_t *v);
-parser_error_t print_c_export_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
-                                 char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
-parser_error_t print_c_import_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
-                                 char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
+// Derives totals and fee of a fully parsed tx, rejecting invalid fees
+parser_error_t parser_summary_cchain(parser_tx_t *v);
+// Checks everything rendering relies on without formatting any value
+parser_error_t parser_validate_cchain(const parser_context_t *ctx);
 #ifdef __cplusplus
 }
 #endif
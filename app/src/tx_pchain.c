@@ -16,178 +16,221 @@
 #include "tx_pchain.h"
 
 #include "app_mode.h"
+#include "parser_codec.h"
 #include "parser_impl_common.h"
 #include "parser_print_common.h"
-#include "zxformat.h"
 #include "zxmacros.h"
 
-static parser_error_t parser_base_tx(parser_context_t *c, transferable_in_secp_t *inputs, transferable_out_secp_t *outputs) {
-    // Get outputs
-    CHECK_ERROR(read_u32(c, &outputs->n_outs));
-    if (outputs->n_outs > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
+// P-chain layout steps. The chunked parser retries a step from its start
+// until all of its bytes are available, list steps resume at the next record.
+typedef enum {
+    step_base_outs_count = PARSER_STEP_BODY,
+    step_base_outs,
+    step_base_ins_count,
+    step_base_ins,
+    step_base_memo,
+    step_export_chain,
+    step_export_outs_count,
+    step_export_outs,
+    step_import_chain,
+    step_import_ins_count,
+    step_import_ins,
+    step_validator,
+    step_stake_outs_count,
+    step_stake_outs,
+    step_rewards_owners,
+} pchain_step_e;
+
+static parser_error_t parser_base_tx(parser_context_t *c, parser_tx_t *v, transferable_in_secp_t *inputs,
+                                     transferable_out_secp_t *outputs, output_index_t *index, uint8_t next_step) {
+    if (v->stream.step == step_base_outs_count) {
+        // Get outputs
+        CHECK_ERROR(read_count(c, MAX_OUTPUTS, &outputs->n_outs));
+        if (outputs->n_outs > 0) {
+            CHECK_ERROR(verifyContext(c));
+        }
+        outputs->out_sum = 0;
+        outputs->n_addrs = 0;
+        parser_stream_next_step(c, step_base_outs);
     }
 
-    // Pointer to outputs
-    if (outputs->n_outs > 0) {
-        CHECK_ERROR(verifyContext(c));
-        outputs->outs = c->buffer + c->offset;
-        CHECK_ERROR(parse_transferable_secp_output(c, outputs, true));
+    if (v->stream.step == step_base_outs) {
+        while (v->stream.item < outputs->n_outs) {
+            CHECK_ERROR(parse_transferable_secp_output_record(c, outputs, true, index));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, step_base_ins_count);
     }
 
-    // Get inputs
-    CHECK_ERROR(read_u32(c, &inputs->n_ins));
-    if (inputs->n_ins > MAX_INPUTS) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_base_ins_count) {
+        // Get inputs
+        CHECK_ERROR(read_count(c, MAX_INPUTS, &inputs->n_ins));
+        if (inputs->n_ins > 0) {
+            CHECK_ERROR(verifyContext(c));
+        }
+        inputs->in_sum = 0;
+        parser_stream_next_step(c, step_base_ins);
     }
 
-    // Pointer to inputs
-    if (inputs->n_ins > 0) {
-        CHECK_ERROR(verifyContext(c));
-        inputs->ins = c->buffer + c->offset;
-        CHECK_ERROR(parse_transferable_secp_input(c, inputs));
+    if (v->stream.step == step_base_ins) {
+        while (v->stream.item < inputs->n_ins) {
+            CHECK_ERROR(parse_transferable_secp_input_record(c, inputs));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, step_base_memo);
     }
 
-    // Get Memo Len
-    uint32_t memoLen = 0;
-    CHECK_ERROR(read_u32(c, &memoLen));
-    if (memoLen > MAX_MEMO_LEN) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_base_memo) {
+        // Get Memo Len
+        uint32_t memoLen = 0;
+        CHECK_ERROR(read_u32(c, &memoLen));
+        if (memoLen > MAX_MEMO_LEN) {
+            return parser_unexpected_number_items;
+        }
+        parser_stream_next_step(c, next_step);
     }
 
     return parser_ok;
 }
 
 parser_error_t parser_handle_base_tx(parser_context_t *c, parser_tx_t *v) {
-    return parser_base_tx(c, &v->tx.base_tx.base_secp_ins, &v->tx.base_tx.base_secp_outs);
+    return parser_base_tx(c, v, &v->tx.base_tx.base_secp_ins, &v->tx.base_tx.base_secp_outs, &v->out_index,
+                          PARSER_STEP_DONE);
 }
 
 parser_error_t parser_handle_p_export_tx(parser_context_t *c, parser_tx_t *v) {
     // Parse base tx
-    CHECK_ERROR(parser_base_tx(c, &v->tx.p_export_tx.base_secp_ins, &v->tx.p_export_tx.base_secp_outs));
-
-    // Get destination chain
-    CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
-    v->tx.p_export_tx.destination_chain = c->buffer + c->offset;
-    if (!MEMCMP(PIC(v->tx.p_export_tx.destination_chain), v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
-        return parser_unexpected_chain;
+    CHECK_ERROR(parser_base_tx(c, v, &v->tx.p_export_tx.base_secp_ins, &v->tx.p_export_tx.base_secp_outs, NULL,
+                               step_export_chain));
+
+    if (v->stream.step == step_export_chain) {
+        // Get destination chain
+        CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
+        v->tx.p_export_tx.destination_chain = c->offset;
+        if (!MEMCMP(c->buffer + c->offset, c->buffer + v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
+            return parser_unexpected_chain;
+        }
+        CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
+        parser_stream_next_step(c, step_export_outs_count);
     }
-    CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
 
-    // Get number of outputs
-    CHECK_ERROR(read_u32(c, &v->tx.p_export_tx.secp_outs.n_outs));
-    if (v->tx.p_export_tx.secp_outs.n_outs > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_export_outs_count) {
+        // Get number of outputs
+        CHECK_ERROR(read_count(c, MAX_OUTPUTS, &v->tx.p_export_tx.secp_outs.n_outs));
+        CHECK_ERROR(verifyContext(c));
+        v->tx.p_export_tx.secp_outs.out_sum = 0;
+        v->tx.p_export_tx.secp_outs.n_addrs = 0;
+        parser_stream_next_step(c, step_export_outs);
     }
 
-    // Pointer to outputs
-    CHECK_ERROR(verifyContext(c));
-    v->tx.p_export_tx.secp_outs.outs = c->buffer + c->offset;
-    v->tx.p_export_tx.secp_outs.outs_offset = c->offset;
-    CHECK_ERROR(parse_transferable_secp_output(c, &v->tx.p_export_tx.secp_outs, true));
+    if (v->stream.step == step_export_outs) {
+        while (v->stream.item < v->tx.p_export_tx.secp_outs.n_outs) {
+            CHECK_ERROR(parse_transferable_secp_output_record(c, &v->tx.p_export_tx.secp_outs, true, &v->out_index));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, PARSER_STEP_DONE);
+    }
 
     return parser_ok;
 }
 
 parser_error_t parser_handle_p_import_tx(parser_context_t *c, parser_tx_t *v) {
     // Parse base tx
-    CHECK_ERROR(parser_base_tx(c, &v->tx.p_import_tx.base_secp_ins, &v->tx.p_import_tx.base_secp_outs));
-
-    // Get source chain
-    CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
-    v->tx.p_import_tx.source_chain = c->buffer + c->offset;
-    if (!MEMCMP(v->tx.p_import_tx.source_chain, v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
-        return parser_unexpected_chain;
+    CHECK_ERROR(parser_base_tx(c, v, &v->tx.p_import_tx.base_secp_ins, &v->tx.p_import_tx.base_secp_outs, &v->out_index,
+                               step_import_chain));
+
+    if (v->stream.step == step_import_chain) {
+        // Get source chain
+        CHECK_ERROR(checkAvailableBytes(c, BLOCKCHAIN_ID_LEN));
+        v->tx.p_import_tx.source_chain = c->offset;
+        if (!MEMCMP(c->buffer + c->offset, c->buffer + v->blockchain_id, BLOCKCHAIN_ID_LEN)) {
+            return parser_unexpected_chain;
+        }
+        CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
+        parser_stream_next_step(c, step_import_ins_count);
     }
-    CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
 
-    // Get number of inputs
-    CHECK_ERROR(read_u32(c, &v->tx.p_import_tx.secp_ins.n_ins));
-    if (v->tx.p_import_tx.secp_ins.n_ins > MAX_INPUTS) {
-        return parser_unexpected_number_items;
+    if (v->stream.step == step_import_ins_count) {
+        // Get number of inputs
+        CHECK_ERROR(read_count(c, MAX_INPUTS, &v->tx.p_import_tx.secp_ins.n_ins));
+        CHECK_ERROR(verifyContext(c));
+        v->tx.p_import_tx.secp_ins.in_sum = 0;
+        parser_stream_next_step(c, step_import_ins);
     }
 
-    // Pointer to inputs
-    CHECK_ERROR(verifyContext(c));
-    v->tx.p_import_tx.secp_ins.ins = c->buffer + c->offset;
-    v->tx.p_import_tx.secp_ins.ins_offset = c->offset;
-    CHECK_ERROR(parse_transferable_secp_input(c, &v->tx.p_import_tx.secp_ins));
+    if (v->stream.step == step_import_ins) {
+        while (v->stream.item < v->tx.p_import_tx.secp_ins.n_ins) {
+            CHECK_ERROR(parse_transferable_secp_input_record(c, &v->tx.p_import_tx.secp_ins));
+            parser_stream_next_item(c);
+        }
+        parser_stream_next_step(c, PARSER_STEP_DONE);
+    }
 
     return parser_ok;
 }
-// https://build.avax.network/docs/api-reference/p-chain/txn-format#unsigned-add-permissionless-validator-tx
-// https://build.avax.network/docs/api-reference/p-chain/txn-format#unsigned-add-permissionless-delegator-tx
-parser_error_t parser_handle_add_permissionless_delegator_validator(parser_context_t *c, parser_tx_t *v) {
-    if (v->tx_type == add_permissionless_validator_tx) {
-        CHECK_ERROR(parser_base_tx(c, &v->tx.add_permissionless_validator_tx.base_secp_ins,
-                                   &v->tx.add_permissionless_validator_tx.base_secp_outs));
-    } else {
-        CHECK_ERROR(parser_base_tx(c, &v->tx.add_permissionless_delegator_tx.base_secp_ins,
-                                   &v->tx.add_permissionless_delegator_tx.base_secp_outs));
-    }
 
-    validator_t *validator = (v->tx_type == add_permissionless_validator_tx)
-                                 ? &v->tx.add_permissionless_validator_tx.validator
-                                 : &v->tx.add_permissionless_delegator_tx.validator;
-
-    CHECK_ERROR(verifyContext(c));
-    validator->node_id = c->buffer + c->offset;
-    CHECK_ERROR(verifyBytes(c, NODE_ID_LEN));
-
-    CHECK_ERROR(read_u64(c, &validator->start_time));
-
-    CHECK_ERROR(read_u64(c, &validator->end_time));
-
-    if (validator->end_time <= validator->start_time) {
+// Validator: node ID, start time, end time, weight, subnet ID
+enum { validator_node_id, validator_start_time, validator_end_time, validator_weight, validator_subnet_id };
+static const codec_field_t validator_fields[] = {
+    CODEC_BYTES(NODE_ID_LEN, validator_node_id),
+    CODEC_U64(validator_start_time),
+    CODEC_U64(validator_end_time),
+    CODEC_U64(validator_weight),
+    CODEC_BYTES(BLOCKCHAIN_ID_LEN, validator_subnet_id),
+};
+static const codec_schema_t validator_schema = CODEC_SCHEMA(validator_fields);
+
+// ProofOfPossession signer: BLS public key and signature
+enum { pop_public_key, pop_signature };
+static const codec_field_t proof_of_possession_fields[] = {
+    CODEC_BYTES(BLS_PUBLIC_KEY_LEN, pop_public_key),
+    CODEC_BYTES(BLS_SIGNATURE_LEN, pop_signature),
+};
+static const codec_schema_t proof_of_possession_schema = CODEC_SCHEMA(proof_of_possession_fields);
+
+static parser_error_t parser_validator(parser_context_t *c, parser_tx_t *v, validator_t *validator) {
+    codec_record_t record;
+    CHECK_ERROR(codec_decode(c, &validator_schema, &record));
+
+    if (record.value[validator_end_time] <= record.value[validator_start_time]) {
         return parser_invalid_time_stamp;
     }
 
-    CHECK_ERROR(read_u64(c, &validator->weight));
+    validator->node_id = record.offset[validator_node_id];
+    CHECK_ERROR(encodeNodeId(c->buffer + validator->node_id, validator->node_id_str, sizeof(validator->node_id_str)))
+    validator->start_time = record.value[validator_start_time];
+    validator->end_time = record.value[validator_end_time];
+    validator->weight = record.value[validator_weight];
 
-    CHECK_ERROR(verifyContext(c));
+    const uint16_t subnet_id = record.offset[validator_subnet_id];
     if (v->tx_type == add_permissionless_validator_tx) {
-        v->tx.add_permissionless_validator_tx.subnet_id = c->buffer + c->offset;
+        v->tx.add_permissionless_validator_tx.subnet_id = subnet_id;
     } else {
-        v->tx.add_permissionless_delegator_tx.subnet_id = c->buffer + c->offset;
+        v->tx.add_permissionless_delegator_tx.subnet_id = subnet_id;
     }
-    CHECK_ERROR(verifyBytes(c, BLOCKCHAIN_ID_LEN));
 
     if (v->tx_type == add_permissionless_validator_tx) {
-        CHECK_ERROR(read_u32(c, &v->tx.add_permissionless_validator_tx.signer.signer_type));
-        if (v->tx.add_permissionless_validator_tx.signer.signer_type == PROOF_OF_POSSESSION_TYPE_ID) {
-            CHECK_ERROR(verifyContext(c));
-            v->tx.add_permissionless_validator_tx.signer.proof_of_possession.public_key = c->buffer + c->offset;
-            CHECK_ERROR(verifyBytes(c, 48));
-
-            CHECK_ERROR(verifyContext(c));
-            v->tx.add_permissionless_validator_tx.signer.proof_of_possession.signature = c->buffer + c->offset;
-            CHECK_ERROR(verifyBytes(c, 96));
-        } else if (v->tx.add_permissionless_validator_tx.signer.signer_type != EMPTY_SIGNER_TYPE_ID) {
+        signer_t *signer = &v->tx.add_permissionless_validator_tx.signer;
+        uint32_t signer_type = 0;
+        CHECK_ERROR(read_u32(c, &signer_type));
+        if (signer_type == PROOF_OF_POSSESSION_TYPE_ID) {
+            CHECK_ERROR(codec_decode(c, &proof_of_possession_schema, &record));
+            signer->proof_of_possession.public_key = record.offset[pop_public_key];
+            signer->proof_of_possession.signature = record.offset[pop_signature];
+        } else if (signer_type != EMPTY_SIGNER_TYPE_ID) {
             return parser_unexpected_type;
         }
+        signer->signer_type = (uint8_t)signer_type;
     }
 
-    transferable_out_secp_t *stake_outs = (v->tx_type == add_permissionless_validator_tx)
-                                              ? &v->tx.add_permissionless_validator_tx.stake_outs
-                                              : &v->tx.add_permissionless_delegator_tx.stake_outs;
-
-    CHECK_ERROR(read_u32(c, &stake_outs->n_outs));
-    if (stake_outs->n_outs > MAX_OUTPUTS) {
-        return parser_unexpected_number_items;
-    }
-
-    CHECK_ERROR(verifyContext(c));
-    stake_outs->outs = c->buffer + c->offset;
-    CHECK_ERROR(parse_transferable_secp_output(c, stake_outs, false));
-
-    if (validator->weight != stake_outs->out_sum) {
-        return parser_invalid_stake_amount;
-    }
+    return parser_ok;
+}
 
+static parser_error_t parser_rewards_owners(parser_context_t *c, parser_tx_t *v) {
     if (v->tx_type == add_permissionless_validator_tx) {
         CHECK_ERROR(verifyContext(c));
-        v->tx.add_permissionless_validator_tx.validator_rewards_owner.outs = c->buffer + c->offset;
         v->tx.add_permissionless_validator_tx.validator_rewards_owner.n_outs = 1;
+        v->tx.add_permissionless_validator_tx.validator_rewards_owner.n_addr = 0;
         CHECK_ERROR(parse_secp_owners_output(c, &v->tx.add_permissionless_validator_tx.validator_rewards_owner));
     }
 
@@ -196,8 +239,8 @@ parser_error_t parser_handle_add_permissionless_delegator_validator(parser_conte
                                                      : &v->tx.add_permissionless_delegator_tx.delegator_rewards_owner;
 
     CHECK_ERROR(verifyContext(c));
-    delegator_rewards_owner->outs = c->buffer + c->offset;
     delegator_rewards_owner->n_outs = 1;
+    delegator_rewards_owner->n_addr = 0;
     CHECK_ERROR(parse_secp_owners_output(c, delegator_rewards_owner));
 
     if (v->tx_type == add_permissionless_validator_tx) {
@@ -213,6 +256,58 @@ parser_error_t parser_handle_add_permissionless_delegator_validator(parser_conte
     return parser_ok;
 }
 
+// https://build.avax.network/docs/api-reference/p-chain/txn-format#unsigned-add-permissionless-validator-tx
+// https://build.avax.network/docs/api-reference/p-chain/txn-format#unsigned-add-permissionless-delegator-tx
+parser_error_t parser_handle_add_permissionless_delegator_validator(parser_context_t *c, parser_tx_t *v) {
+    if (v->tx_type == add_permissionless_validator_tx) {
+        CHECK_ERROR(parser_base_tx(c, v, &v->tx.add_permissionless_validator_tx.base_secp_ins,
+                                   &v->tx.add_permissionless_validator_tx.base_secp_outs, NULL, step_validator));
+    } else {
+        CHECK_ERROR(parser_base_tx(c, v, &v->tx.add_permissionless_delegator_tx.base_secp_ins,
+                                   &v->tx.add_permissionless_delegator_tx.base_secp_outs, NULL, step_validator));
+    }
+
+    validator_t *validator = (v->tx_type == add_permissionless_validator_tx)
+                                 ? &v->tx.add_permissionless_validator_tx.validator
+                                 : &v->tx.add_permissionless_delegator_tx.validator;
+
+    transferable_out_secp_t *stake_outs = (v->tx_type == add_permissionless_validator_tx)
+                                              ? &v->tx.add_permissionless_validator_tx.stake_outs
+                                              : &v->tx.add_permissionless_delegator_tx.stake_outs;
+
+    if (v->stream.step == step_validator) {
+        CHECK_ERROR(parser_validator(c, v, validator));
+        parser_stream_next_step(c, step_stake_outs_count);
+    }
+
+    if (v->stream.step == step_stake_outs_count) {
+        CHECK_ERROR(read_count(c, MAX_OUTPUTS, &stake_outs->n_outs));
+        CHECK_ERROR(verifyContext(c));
+        stake_outs->out_sum = 0;
+        stake_outs->n_addrs = 0;
+        parser_stream_next_step(c, step_stake_outs);
+    }
+
+    if (v->stream.step == step_stake_outs) {
+        while (v->stream.item < stake_outs->n_outs) {
+            CHECK_ERROR(parse_transferable_secp_output_record(c, stake_outs, false, NULL));
+            parser_stream_next_item(c);
+        }
+
+        if (validator->weight != stake_outs->out_sum) {
+            return parser_invalid_stake_amount;
+        }
+        parser_stream_next_step(c, step_rewards_owners);
+    }
+
+    if (v->stream.step == step_rewards_owners) {
+        CHECK_ERROR(parser_rewards_owners(c, v));
+        parser_stream_next_step(c, PARSER_STEP_DONE);
+    }
+
+    return parser_ok;
+}
+
 parser_error_t parser_pchain(parser_context_t *c, parser_tx_t *v) {
     switch (v->tx_type) {
         case base_tx:
@@ -236,301 +331,107 @@ parser_error_t parser_pchain(parser_context_t *c, parser_tx_t *v) {
     return parser_ok;
 }
 
-parser_error_t print_p_export_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
-                                 char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    if (displayIdx == 0) {
-        snprintf(outKey, outKeyLen, "Export");
-
-        char chain = 0;
-        CHECK_ERROR(parser_get_chain_alias(ctx->tx_obj->tx.p_export_tx.destination_chain, &chain));
-        snprintf(outVal, outValLen, "P to %c chain", chain);
-        return parser_ok;
-    }
-
-    // print ampount and addresses
-    if (displayIdx <= ctx->tx_obj->tx.p_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.p_export_tx.secp_outs.n_outs) {
-        // Create new context parser for outputs
-        parser_context_t output_ctx = {.buffer = ctx->tx_obj->tx.p_export_tx.secp_outs.outs,
-                                       .bufferLen = ctx->bufferLen - ctx->tx_obj->tx.p_export_tx.secp_outs.outs_offset + 1,
-                                       .offset = 0,
-                                       .tx_obj = NULL};
-
-        uint8_t inner_displayIdx = displayIdx - 1;
-        uint8_t element_idx = 0;
-        uint64_t amount = 0;
-        uint8_t address[ADDRESS_LEN] = {0};
-
-        // check which output cointains the displayIdx we want
-        CHECK_ERROR(parser_get_secp_output_for_index(&output_ctx, ctx->tx_obj->tx.p_export_tx.secp_outs, inner_displayIdx,
-                                                     &amount, address, &element_idx));
-        if (!element_idx) {
-            snprintf(outKey, outKeyLen, "Amount");
-            CHECK_ERROR(printAmount64(amount, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                      pageCount));
-        } else {
-            snprintf(outKey, outKeyLen, "Address");
-            CHECK_ERROR(printAddress(address, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        }
-        return parser_ok;
-    }
-
-    if (displayIdx == ctx->tx_obj->tx.p_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.p_export_tx.secp_outs.n_outs + 1) {
-        snprintf(outKey, outKeyLen, "Fee");
-        if (UINT64_MAX - ctx->tx_obj->tx.p_export_tx.base_secp_outs.out_sum <
-            ctx->tx_obj->tx.p_export_tx.secp_outs.out_sum) {
-            // Prevent overflow
-            return parser_unexpected_value;
-        }
-        uint64_t outs_total =
-            ctx->tx_obj->tx.p_export_tx.base_secp_outs.out_sum + ctx->tx_obj->tx.p_export_tx.secp_outs.out_sum;
-
-        if (outs_total > ctx->tx_obj->tx.p_export_tx.base_secp_ins.in_sum) {
-            // Prevent underflow
-            return parser_unexpected_value;
-        }
-
-        uint64_t fee = ctx->tx_obj->tx.p_export_tx.base_secp_ins.in_sum - outs_total;
-
-        CHECK_ERROR(
-            printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        return parser_ok;
+// Fee left by inputs once outputs and stake are paid
+static parser_error_t summary_fee(tx_summary_t *summary, parser_error_t underflow_error) {
+    if (UINT64_MAX - summary->total_out < summary->staked) {
+        // Prevent overflow
+        return parser_unexpected_value;
     }
-
-    if (displayIdx == ctx->tx_obj->tx.p_export_tx.secp_outs.n_addrs + ctx->tx_obj->tx.p_export_tx.secp_outs.n_outs + 1 + 1) {
-        snprintf(outKey, outKeyLen, "Hash");
-        printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-        return parser_ok;
+    if (summary->total_out + summary->staked > summary->total_in) {
+        // Prevent underflow
+        return underflow_error;
     }
-
-    return parser_display_idx_out_of_range;
+    summary->fee = summary->total_in - (summary->total_out + summary->staked);
+    return parser_ok;
 }
 
-parser_error_t print_p_import_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
-                                 char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    if (displayIdx == 0) {
-        snprintf(outKey, outKeyLen, "Import");
-
-        char chain = 0;
-        CHECK_ERROR(parser_get_chain_alias(ctx->tx_obj->tx.p_import_tx.source_chain, &chain));
-        snprintf(outVal, outValLen, "P from %c chain", chain);
-        return parser_ok;
-    }
-
-    // print ampount and addresses
-    if (displayIdx <=
-        ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_outs) {
-        // Create new context parser for outputs
-        parser_context_t output_ctx = {
-            .buffer = ctx->tx_obj->tx.p_import_tx.base_secp_outs.outs,
-            .bufferLen = ctx->bufferLen - ctx->tx_obj->tx.p_import_tx.base_secp_outs.outs_offset + 1,
-            .offset = 0,
-            .tx_obj = NULL};
-
-        uint8_t inner_displayIdx = displayIdx - 1;
-        uint8_t element_idx = 0;
-        uint64_t amount = 0;
-        uint8_t address[ADDRESS_LEN] = {0};
-
-        // check which output cointains the displayIdx we want
-        CHECK_ERROR(parser_get_secp_output_for_index(&output_ctx, ctx->tx_obj->tx.p_import_tx.base_secp_outs,
-                                                     inner_displayIdx, &amount, address, &element_idx));
-
-        if (!element_idx) {
-            snprintf(outKey, outKeyLen, "Amount");
-            CHECK_ERROR(printAmount64(amount, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                      pageCount));
-        } else {
-            snprintf(outKey, outKeyLen, "Address");
-            CHECK_ERROR(printAddress(address, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        }
-        return parser_ok;
-    }
+parser_error_t parser_summary_pchain(parser_tx_t *v) {
+    tx_summary_t *summary = &v->summary;
+    MEMZERO(summary, sizeof(*summary));
 
-    if (displayIdx ==
-        ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_outs + 1) {
-        snprintf(outKey, outKeyLen, "Fee");
+    switch (v->tx_type) {
+        case base_tx:
+            summary->total_in = v->tx.base_tx.base_secp_ins.in_sum;
+            summary->total_out = v->tx.base_tx.base_secp_outs.out_sum;
+            summary->n_outputs = v->tx.base_tx.base_secp_outs.n_outs;
+            // Invalid transaction: outputs exceed inputs
+            return summary_fee(summary, parser_unexpected_error);
 
-        uint64_t base_secp_ins_in_sum = ctx->tx_obj->tx.p_import_tx.base_secp_ins.in_sum;
-        uint64_t secp_ins_in_sum = ctx->tx_obj->tx.p_import_tx.secp_ins.in_sum;
-        uint64_t base_secp_outs_out_sum = ctx->tx_obj->tx.p_import_tx.base_secp_outs.out_sum;
+        case p_export_tx:
+            if (UINT64_MAX - v->tx.p_export_tx.base_secp_outs.out_sum < v->tx.p_export_tx.secp_outs.out_sum) {
+                // Prevent overflow
+                return parser_unexpected_value;
+            }
+            summary->total_in = v->tx.p_export_tx.base_secp_ins.in_sum;
+            summary->total_out = v->tx.p_export_tx.base_secp_outs.out_sum + v->tx.p_export_tx.secp_outs.out_sum;
+            summary->n_outputs = v->tx.p_export_tx.secp_outs.n_outs;
+            return summary_fee(summary, parser_unexpected_value);
 
-        // Prevent overflow
-        if (base_secp_ins_in_sum > UINT64_MAX - secp_ins_in_sum) {
-            return parser_unexpected_value;
-        }
+        case p_import_tx:
+            if (v->tx.p_import_tx.base_secp_ins.in_sum > UINT64_MAX - v->tx.p_import_tx.secp_ins.in_sum) {
+                // Prevent overflow
+                return parser_unexpected_value;
+            }
+            summary->total_in = v->tx.p_import_tx.base_secp_ins.in_sum + v->tx.p_import_tx.secp_ins.in_sum;
+            summary->total_out = v->tx.p_import_tx.base_secp_outs.out_sum;
+            summary->n_outputs = v->tx.p_import_tx.base_secp_outs.n_outs;
+            return summary_fee(summary, parser_unexpected_value);
 
-        // Prevent underflow
-        if (base_secp_ins_in_sum + secp_ins_in_sum < base_secp_outs_out_sum) {
-            return parser_unexpected_value;
-        }
+        case add_permissionless_validator_tx:
+            summary->total_in = v->tx.add_permissionless_validator_tx.base_secp_ins.in_sum;
+            summary->total_out = v->tx.add_permissionless_validator_tx.base_secp_outs.out_sum;
+            summary->staked = v->tx.add_permissionless_validator_tx.stake_outs.out_sum;
+            return summary_fee(summary, parser_unexpected_value);
 
-        uint64_t fee = (base_secp_ins_in_sum + secp_ins_in_sum) - base_secp_outs_out_sum;
-        CHECK_ERROR(
-            printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        return parser_ok;
-    }
+        case add_permissionless_delegator_tx:
+            summary->total_in = v->tx.add_permissionless_delegator_tx.base_secp_ins.in_sum;
+            summary->total_out = v->tx.add_permissionless_delegator_tx.base_secp_outs.out_sum;
+            summary->staked = v->tx.add_permissionless_delegator_tx.stake_outs.out_sum;
+            return summary_fee(summary, parser_unexpected_value);
 
-    if (displayIdx ==
-        ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.p_import_tx.base_secp_outs.n_outs + 1 + 1) {
-        snprintf(outKey, outKeyLen, "Hash");
-        printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-        return parser_ok;
+        default:
+            return parser_unexpected_type;
     }
-
-    return parser_display_idx_out_of_range;
 }
 
-parser_error_t print_add_permissionless_del_val_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey,
-                                                   uint16_t outKeyLen, char *outVal, uint16_t outValLen, uint8_t pageIdx,
-                                                   uint8_t *pageCount) {
-    const validator_t *validator = (ctx->tx_obj->tx_type == add_permissionless_validator_tx)
-                                       ? &ctx->tx_obj->tx.add_permissionless_validator_tx.validator
-                                       : &ctx->tx_obj->tx.add_permissionless_delegator_tx.validator;
-
-    switch (displayIdx) {
-        case 0:
-            snprintf(outKey, outKeyLen, "Validator");
-            CHECK_ERROR(printNodeId(validator->node_id, outVal, outValLen, pageIdx, pageCount));
-            break;
-        case 1:
-            snprintf(outKey, outKeyLen, "Start time");
-            CHECK_ERROR(printTimestamp(validator->start_time, outVal, outValLen, pageIdx, pageCount));
-            break;
-        case 2:
-            snprintf(outKey, outKeyLen, "End time");
-            CHECK_ERROR(printTimestamp(validator->end_time, outVal, outValLen, pageIdx, pageCount));
-            break;
-        case 3:
-            snprintf(outKey, outKeyLen, "Total stake");
-            CHECK_ERROR(printAmount64(validator->weight, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen,
-                                      pageIdx, pageCount));
-            break;
-        case 4:
-            if (ctx->tx_obj->tx_type == add_permissionless_validator_tx) {
-                snprintf(outKey, outKeyLen, "Rewards to");
-                CHECK_ERROR(printAddress(ctx->tx_obj->tx.add_permissionless_validator_tx.validator_rewards_owner.addr,
-                                         ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-            } else {
-                snprintf(outKey, outKeyLen, "Rewards to");
-                CHECK_ERROR(printAddress(ctx->tx_obj->tx.add_permissionless_delegator_tx.delegator_rewards_owner.addr,
-                                         ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-            }
-            break;
-        case 5:
-            if (ctx->tx_obj->tx_type == add_permissionless_validator_tx) {
-                snprintf(outKey, outKeyLen, "Delegate fee");
-                uint32_t shares = ctx->tx_obj->tx.add_permissionless_validator_tx.delegation_shares;
-                snprintf(outVal, outValLen, "%u %%", shares / 10000);
-                break;
-            } else {
-                snprintf(outKey, outKeyLen, "Fee");
-                if (UINT64_MAX - ctx->tx_obj->tx.add_permissionless_delegator_tx.base_secp_outs.out_sum <
-                    ctx->tx_obj->tx.add_permissionless_delegator_tx.stake_outs.out_sum) {
-                    return parser_unexpected_value;
-                }
-                uint64_t outs_total = ctx->tx_obj->tx.add_permissionless_delegator_tx.base_secp_outs.out_sum +
-                                      ctx->tx_obj->tx.add_permissionless_delegator_tx.stake_outs.out_sum;
-
-                if (outs_total > ctx->tx_obj->tx.add_permissionless_delegator_tx.base_secp_ins.in_sum) {
-                    return parser_unexpected_value;
-                }
-                uint64_t fee = ctx->tx_obj->tx.add_permissionless_delegator_tx.base_secp_ins.in_sum -
-                               (ctx->tx_obj->tx.add_permissionless_delegator_tx.base_secp_outs.out_sum +
-                                ctx->tx_obj->tx.add_permissionless_delegator_tx.stake_outs.out_sum);
-                CHECK_ERROR(printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                          pageCount));
-                break;
-            }
-        case 6:
-            if (ctx->tx_obj->tx_type == add_permissionless_validator_tx) {
-                snprintf(outKey, outKeyLen, "Fee");
-                if (UINT64_MAX - ctx->tx_obj->tx.add_permissionless_validator_tx.base_secp_outs.out_sum <
-                    ctx->tx_obj->tx.add_permissionless_validator_tx.stake_outs.out_sum) {
-                    // Prevent overflow
-                    return parser_unexpected_value;
-                }
-                uint64_t outs_total = ctx->tx_obj->tx.add_permissionless_validator_tx.base_secp_outs.out_sum +
-                                      ctx->tx_obj->tx.add_permissionless_validator_tx.stake_outs.out_sum;
-
-                if (outs_total > ctx->tx_obj->tx.add_permissionless_validator_tx.base_secp_ins.in_sum) {
-                    // Prevent underflow
-                    return parser_unexpected_value;
-                }
-
-                uint64_t fee = ctx->tx_obj->tx.add_permissionless_validator_tx.base_secp_ins.in_sum -
-                               (ctx->tx_obj->tx.add_permissionless_validator_tx.base_secp_outs.out_sum +
-                                ctx->tx_obj->tx.add_permissionless_validator_tx.stake_outs.out_sum);
-                CHECK_ERROR(printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                          pageCount));
-            } else {
-                snprintf(outKey, outKeyLen, "Hash");
-                printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-            }
-            break;
-        case 7:
-            if (ctx->tx_obj->tx_type == add_permissionless_validator_tx) {
-                snprintf(outKey, outKeyLen, "Hash");
-                printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-            } else {
-                return parser_display_idx_out_of_range;
-            }
-            break;
-        default:
-            return parser_display_idx_out_of_range;
+// Every timestamp formatTimestamp accepts can be shown
+static parser_error_t validate_timestamp(uint64_t timestamp) {
+    if (timestamp > TIMESTAMP_MAX) {
+        return parser_unexpected_error;
     }
     return parser_ok;
 }
 
-parser_error_t print_base_tx(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outVal,
-                             uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
-    if (displayIdx == 0) {
-        snprintf(outKey, outKeyLen, "Send");
-        snprintf(outVal, outValLen, "P chain");
-        return parser_ok;
-    }
+parser_error_t parser_validate_pchain(const parser_context_t *ctx) {
+    const parser_tx_t *v = ctx->tx_obj;
+    char chain = 0;
 
-    if (displayIdx <= ctx->tx_obj->tx.base_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.base_tx.base_secp_outs.n_outs) {
-        parser_context_t output_ctx = {.buffer = ctx->tx_obj->tx.base_tx.base_secp_outs.outs,
-                                       .bufferLen = ctx->bufferLen - ctx->tx_obj->tx.base_tx.base_secp_outs.outs_offset + 1,
-                                       .offset = 0,
-                                       .tx_obj = NULL};
-
-        uint8_t inner_displayIdx = displayIdx - 1;
-        uint8_t element_idx = 0;
-        uint64_t amount = 0;
-        uint8_t address[ADDRESS_LEN] = {0};
-
-        CHECK_ERROR(parser_get_secp_output_for_index(&output_ctx, ctx->tx_obj->tx.base_tx.base_secp_outs, inner_displayIdx,
-                                                     &amount, address, &element_idx));
-        if (!element_idx) {
-            snprintf(outKey, outKeyLen, "Amount");
-            CHECK_ERROR(printAmount64(amount, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx,
-                                      pageCount));
-        } else {
-            snprintf(outKey, outKeyLen, "Address");
-            CHECK_ERROR(printAddress(address, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        }
-        return parser_ok;
-    }
+    // Output items need no check: the index they are read through is built from the records the parser consumed
+    switch (v->tx_type) {
+        case base_tx:
+            return parser_ok;
+
+        case p_export_tx:
+            return parser_get_chain_alias(v->network_id, parser_tx_field(ctx, v->tx.p_export_tx.destination_chain), &chain);
+
+        case p_import_tx:
+            return parser_get_chain_alias(v->network_id, parser_tx_field(ctx, v->tx.p_import_tx.source_chain), &chain);
 
-    if (displayIdx == ctx->tx_obj->tx.base_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.base_tx.base_secp_outs.n_outs + 1) {
-        snprintf(outKey, outKeyLen, "Fee");
-        // Check for underflow before subtraction
-        if (ctx->tx_obj->tx.base_tx.base_secp_ins.in_sum < ctx->tx_obj->tx.base_tx.base_secp_outs.out_sum) {
-            return parser_unexpected_error;  // Invalid transaction: outputs exceed inputs
+        case add_permissionless_delegator_tx:
+        case add_permissionless_validator_tx: {
+            const bool is_validator = v->tx_type == add_permissionless_validator_tx;
+            const validator_t *validator = is_validator ? &v->tx.add_permissionless_validator_tx.validator
+                                                        : &v->tx.add_permissionless_delegator_tx.validator;
+            const uint16_t rewards_addr = is_validator ? v->tx.add_permissionless_validator_tx.validator_rewards_owner.addr
+                                                        : v->tx.add_permissionless_delegator_tx.delegator_rewards_owner.addr;
+            if (parser_tx_field(ctx, validator->node_id) == NULL || parser_tx_field(ctx, rewards_addr) == NULL) {
+                return parser_unexpected_error;
+            }
+            CHECK_ERROR(validate_timestamp(validator->start_time));
+            return validate_timestamp(validator->end_time);
         }
-        uint64_t fee = ctx->tx_obj->tx.base_tx.base_secp_ins.in_sum - ctx->tx_obj->tx.base_tx.base_secp_outs.out_sum;
-        CHECK_ERROR(
-            printAmount64(fee, AMOUNT_DECIMAL_PLACES, ctx->tx_obj->network_id, outVal, outValLen, pageIdx, pageCount));
-        return parser_ok;
-    }
 
-    if (displayIdx ==
-        ctx->tx_obj->tx.base_tx.base_secp_outs.n_addrs + ctx->tx_obj->tx.base_tx.base_secp_outs.n_outs + 1 + 1) {
-        snprintf(outKey, outKeyLen, "Hash");
-        printHash(ctx, outVal, outValLen, pageIdx, pageCount);
-        return parser_ok;
+        default:
+            return parser_unexpected_type;
     }
-
-    return parser_display_idx_out_of_range;
 }
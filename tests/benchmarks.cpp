@@ -0,0 +1,450 @@
+/*******************************************************************************
+ *   (c) 2018 - 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "app_mode.h"
+#include "base58.h"
+#include "bech32.h"
+#include "bech32_address.h"
+#include "bip32_cache.h"
+#include "coin.h"
+#include "evm_number.h"
+#include "evm_utils.h"
+#include "gtest/gtest.h"
+#include "networks.h"
+#include "parser.h"
+#include "parser_common.h"
+#include "parser_print_common.h"
+#include "parser_txdef.h"
+#include "timeutils.h"
+#include "zxformat.h"
+#include "utils/bip32_shim.h"
+#include "utils/tx_builder.h"
+
+extern "C" parser_error_t _getItemFlr(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
+                                      char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
+
+namespace {
+
+// Number of timed calls per measurement; the minimum of several rounds is
+// reported to keep scheduler noise out of the numbers. Timings are only
+// reported: the assertions check results and operation counts.
+constexpr uint32_t kBenchIterations = 2000;
+constexpr uint32_t kBenchRounds = 5;
+
+// Best per-call time, in nanoseconds, of body(i) over iterations calls
+template <typename F>
+double best_ns(F &&body, uint32_t iterations = kBenchIterations) {
+    double best = 0;
+    for (uint32_t round = 0; round < kBenchRounds; round++) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            body(i);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        if (round == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+// Mainnet P-chain BaseTx with n_outs outputs of addrs_per_out owners each,
+// funded by a single input so the fee stays positive. With n_destinations set,
+// output i pays the same owners as output i % n_destinations.
+std::vector<uint8_t> build_base_tx(uint32_t n_outs, uint32_t addrs_per_out, uint32_t n_destinations = 0) {
+    std::vector<base_tx_output_t> outputs;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < n_outs; i++) {
+        const uint32_t destination = n_destinations ? i % n_destinations : i;
+        base_tx_output_t output = {1000000000ULL + i, ""};
+        for (uint32_t j = 0; j < addrs_per_out; j++) {
+            output.owners += address_hex(static_cast<uint8_t>(0x20 + destination + j));
+        }
+        total += output.amount;
+        outputs.push_back(output);
+    }
+    return base_tx_bytes(outputs, total + 1000000ULL);
+}
+
+typedef parser_error_t (*get_item_fn)(const parser_context_t *, uint8_t, char *, uint16_t, char *, uint16_t, uint8_t,
+                                       uint8_t *);
+
+// Best per-call time, in nanoseconds, of fetching pages [0, pages) of displayIdx
+double time_get_item(const parser_context_t *ctx, uint8_t displayIdx, get_item_fn get_item = _getItemFlr,
+                     uint16_t outValLen = 40, uint8_t pages = 1) {
+    char outKey[40];
+    char outVal[40];
+    uint8_t pageCount = 0;
+    return best_ns([&](uint32_t i) {
+        get_item(ctx, displayIdx, outKey, sizeof(outKey), outVal, outValLen, i % pages, &pageCount);
+    });
+}
+
+}  // namespace
+
+TEST(Benchmark, OutputLookupIsIndependentOfPosition) {
+    app_mode_set_expert(false);
+
+    printf("%8s %8s %14s %14s\n", "outputs", "addrs", "first ns/item", "last ns/item");
+    for (uint32_t addrs_per_out : {1U, 2U}) {
+        for (uint32_t n_outs : {1U, 2U, 4U, 8U, 16U, 32U, (uint32_t)MAX_OUTPUTS}) {
+            const std::vector<uint8_t> blob = build_base_tx(n_outs, addrs_per_out);
+
+            parser_context_t ctx;
+            parser_tx_t tx_obj;
+            memset(&tx_obj, 0, sizeof(tx_obj));
+            ASSERT_EQ(parser_parse(&ctx, blob.data(), blob.size(), &tx_obj), parser_ok) << n_outs << " outputs";
+            ASSERT_EQ(parser_validate(&ctx), parser_ok) << n_outs << " outputs";
+            ASSERT_EQ(tx_obj.out_index.n_items, n_outs * (1 + addrs_per_out));
+
+            // Amount of the first and of the last output
+            const uint8_t first_idx = 1;
+            const uint8_t last_idx = static_cast<uint8_t>(1 + (n_outs - 1) * (1 + addrs_per_out));
+
+            const double first_ns = time_get_item(&ctx, first_idx);
+            const double last_ns = time_get_item(&ctx, last_idx);
+            // A lookup that rescanned the outputs would grow ~64x down the table
+            printf("%8u %8u %14.1f %14.1f\n", n_outs, addrs_per_out, first_ns, last_ns);
+        }
+    }
+}
+
+TEST(Benchmark, PagingThroughAnAddressReusesTheRenderedValue) {
+    app_mode_set_expert(false);
+
+    const std::vector<uint8_t> blob = build_base_tx(1, 1);
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    ASSERT_EQ(parser_parse(&ctx, blob.data(), blob.size(), &tx_obj), parser_ok);
+    ASSERT_EQ(parser_validate(&ctx), parser_ok);
+
+    // Address of the only output, split in 12-character pages
+    const uint8_t address_idx = 2;
+    const uint16_t outValLen = 13;
+    char outKey[40];
+    char outVal[40];
+    uint8_t pages = 0;
+    ASSERT_EQ(parser_getItem(&ctx, address_idx, outKey, sizeof(outKey), outVal, outValLen, 0, &pages), parser_ok);
+    ASSERT_GT(pages, 1);
+
+    const double direct_ns = time_get_item(&ctx, address_idx, _getItemFlr, outValLen, pages);
+    const double cached_ns = time_get_item(&ctx, address_idx, parser_getItem, outValLen, pages);
+    printf("%8s %16s %16s\n", "pages", "direct ns/page", "cached ns/page");
+    printf("%8u %16.1f %16.1f\n", pages, direct_ns, cached_ns);
+}
+
+TEST(Benchmark, ValidationDoesNotRenderTheReview) {
+    app_mode_set_expert(false);
+
+    const std::vector<uint8_t> blob = build_base_tx(MAX_OUTPUTS, 1);
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    ASSERT_EQ(parser_parse(&ctx, blob.data(), blob.size(), &tx_obj), parser_ok);
+
+    uint8_t numItems = 0;
+    ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+
+    parser_error_t validate_err = parser_ok;
+    const double validate_ns = best_ns([&](uint32_t) {
+        if (validate_err == parser_ok) {
+            validate_err = parser_validate(&ctx);
+        }
+    });
+    EXPECT_EQ(validate_err, parser_ok);
+
+    // What validation used to do: render every item once
+    const double render_ns = best_ns(
+        [&](uint32_t) {
+            char outKey[40];
+            char outVal[40];
+            uint8_t pageCount = 0;
+            for (uint8_t idx = 0; idx < numItems; idx++) {
+                _getItemFlr(&ctx, idx, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount);
+            }
+        },
+        kBenchIterations / 10);
+
+    printf("%8s %8s %16s %16s\n", "outputs", "items", "validate ns", "render all ns");
+    printf("%8u %8u %16.1f %16.1f\n", (uint32_t)MAX_OUTPUTS, numItems, validate_ns, render_ns);
+}
+
+TEST(Benchmark, AmountFormattingIsSinglePass) {
+    // Multi-pass formatting printAmount64 used before: convert, insert the point, trim, join the ticker
+    auto legacy = [](uint64_t amount, char *outVal, uint16_t outValLen, uint8_t *pageCount) {
+        char strAmount[33] = {0};
+        uint64_to_str(strAmount, sizeof(strAmount), amount);
+        intstr_to_fpstr_inplace(strAmount, sizeof(strAmount), AMOUNT_DECIMAL_PLACES);
+        number_inplace_trimming(strAmount, 1);
+        char *point = strchr(strAmount, '.');
+        if (point != nullptr && strspn(point + 1, "0") == strlen(point + 1)) {
+            *point = '\0';
+        }
+        z_str3join(strAmount, sizeof(strAmount), "", " ");
+        z_str3join(strAmount, sizeof(strAmount), "", network_get(mainnet)->ticker);
+        pageString(outVal, outValLen, strAmount, 0, pageCount);
+    };
+
+    const uint64_t amounts[] = {0, 1, 1000000000ULL, 25000000000000ULL, 1234567890123ULL, UINT64_MAX};
+    char outVal[40];
+    uint8_t pageCount = 0;
+
+    printf("%22s %14s %14s\n", "amount", "legacy ns", "single ns");
+    for (uint64_t amount : amounts) {
+        const double legacy_ns = best_ns([&](uint32_t) { legacy(amount, outVal, sizeof(outVal), &pageCount); });
+        const double single_ns = best_ns([&](uint32_t) {
+            printAmount64(amount, AMOUNT_DECIMAL_PLACES, mainnet, outVal, sizeof(outVal), 0, &pageCount);
+        });
+        printf("%22llu %14.1f %14.1f\n", (unsigned long long)amount, legacy_ns, single_ns);
+    }
+}
+
+TEST(Benchmark, EvmNumbersSkipGenericBigIntegerConversion) {
+    // Gas limit, gas price, a typical value in wei and the widest ERC-20 amount
+    const std::vector<std::vector<uint8_t>> numbers = {
+        {0x1b, 0xb2, 0xfc},
+        {0x4d, 0x26, 0x8f, 0xe2, 0x97},
+        {0x09, 0x9c, 0xa8, 0xf3, 0x5e, 0xa1, 0x11, 0x00, 0x00},
+        std::vector<uint8_t>(EVM_NUMBER_MAX_LEN, 0xFF),
+    };
+    char outVal[100];
+    uint8_t pageCount = 0;
+
+    printf("%8s %8s %14s %14s\n", "bytes", "decimals", "zxlib ns", "evm_number ns");
+    for (const auto &number : numbers) {
+        const uint16_t len = static_cast<uint16_t>(number.size());
+        rlp_t rlp;
+        memset(&rlp, 0, sizeof(rlp));
+        rlp.kind = RLP_KIND_STRING;
+        rlp.ptr = number.data();
+        rlp.rlpLen = len;
+
+        for (uint8_t decimals : {(uint8_t)0, (uint8_t)COIN_AMOUNT_DECIMAL}) {
+            const double zxlib_ns = best_ns([&](uint32_t) {
+                if (decimals == 0) {
+                    printRLPNumber(&rlp, outVal, sizeof(outVal), 0, &pageCount);
+                } else {
+                    printBigIntFixedPoint(number.data(), len, outVal, sizeof(outVal), 0, &pageCount, decimals);
+                }
+            });
+            const double evm_ns = best_ns([&](uint32_t) {
+                printEvmNumber(number.data(), len, decimals, NULL, outVal, sizeof(outVal), 0, &pageCount);
+            });
+            printf("%8u %8u %14.1f %14.1f\n", len, decimals, zxlib_ns, evm_ns);
+        }
+    }
+}
+
+TEST(Benchmark, AddressEncodingUsesPrecomputedHrpState) {
+    const network_info_t *network = network_get(mainnet);
+    ASSERT_NE(network, nullptr);
+    const uint8_t hrp_len = strlen(network->hrp);
+
+    uint8_t address[ADDRESS_LEN];
+    for (uint8_t i = 0; i < ADDRESS_LEN; i++) {
+        address[i] = static_cast<uint8_t>(0x5A ^ (i * 37));
+    }
+    char generic[100];
+    char fixed[100];
+
+    const double generic_ns = best_ns([&](uint32_t i) {
+        address[i % ADDRESS_LEN] ^= 1;
+        bech32EncodeFromBytes(generic, sizeof(generic), network->hrp, address, ADDRESS_LEN, 1, BECH32_ENCODING_BECH32);
+    });
+    const double fixed_ns = best_ns([&](uint32_t i) {
+        address[i % ADDRESS_LEN] ^= 1;
+        bech32_encode_address(fixed, sizeof(fixed), network->hrp, hrp_len, network->hrp_state, address);
+    });
+
+    // Both encoders flipped the same bits, so they end on the same address
+    EXPECT_STREQ(fixed, generic);
+    printf("%14s %14s\n", "generic ns", "fixed ns");
+    printf("%14.1f %14.1f\n", generic_ns, fixed_ns);
+}
+
+TEST(Benchmark, NodeIdUsesFixedWidthBase58) {
+    uint8_t payload[NODE_ID_PAYLOAD_LEN];
+    for (uint8_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = static_cast<uint8_t>(0xA5 ^ (i * 29));
+    }
+    unsigned char generic[64];
+    size_t generic_len = 0;
+    char fixed[NODE_ID_BASE58_MAX_LEN + 1];
+
+    const double generic_ns = best_ns([&](uint32_t i) {
+        payload[i % NODE_ID_LEN] ^= 1;
+        generic_len = sizeof(generic);
+        encode_base58(payload, sizeof(payload), generic, &generic_len);
+    });
+    const double fixed_ns = best_ns([&](uint32_t i) {
+        payload[i % NODE_ID_LEN] ^= 1;
+        encode_base58_node_id(payload, fixed);
+    });
+
+    // Both encoders flipped the same bits, so they end on the same payload
+    EXPECT_EQ(std::string(fixed), std::string(reinterpret_cast<const char *>(generic), generic_len));
+    printf("%14s %14s\n", "generic ns", "fixed ns");
+    printf("%14.1f %14.1f\n", generic_ns, fixed_ns);
+}
+
+TEST(Benchmark, TimestampsAvoidSnprintf) {
+    // A staking window: now-ish start times spread over a year
+    const uint64_t base = 1700000000ULL;
+    char legacy[30];
+    char fixed[TIMESTAMP_STR_LEN + 1];
+
+    const double legacy_ns = best_ns([&](uint32_t i) {
+        timedata_t date = {0};
+        extractTime(base + i * 15731ULL, &date);
+        snprintf(legacy, sizeof(legacy), "%04d-%02d-%02d %02d:%02d:%02d UTC", date.tm_year, date.tm_mon, date.tm_day,
+                 date.tm_hour, date.tm_min, date.tm_sec);
+    });
+    const double fixed_ns = best_ns([&](uint32_t i) { formatTimestamp(base + i * 15731ULL, fixed, sizeof(fixed)); });
+
+    EXPECT_STREQ(fixed, legacy);
+    printf("%14s %14s\n", "snprintf ns", "table ns");
+    printf("%14.1f %14.1f\n", legacy_ns, fixed_ns);
+}
+
+TEST(Benchmark, DisplayWritesSkipSnprintf) {
+    char outKey[40];
+    char outVal[40];
+    const uint32_t shares = 200000;
+
+    // What every item did before: clear both buffers, set a key and a short value
+    const double printf_ns = best_ns([&](uint32_t i) {
+        memset(outKey, 0, sizeof(outKey));
+        memset(outVal, 0, sizeof(outVal));
+        snprintf(outKey, sizeof(outKey), "?");
+        snprintf(outVal, sizeof(outVal), " ");
+        snprintf(outKey, sizeof(outKey), "Delegate fee");
+        snprintf(outVal, sizeof(outVal), "%u %%", (shares + i) / 10000);
+    });
+    const double writer_ns = best_ns([&](uint32_t i) {
+        write_str(outKey, sizeof(outKey), "?");
+        write_str(outVal, sizeof(outVal), " ");
+        write_str(outKey, sizeof(outKey), "Delegate fee");
+        writer_t w;
+        writer_init(&w, outVal, sizeof(outVal));
+        writer_append_u64(&w, (shares + i) / 10000);
+        writer_append_str(&w, " %");
+    });
+
+    EXPECT_STREQ(outKey, "Delegate fee");
+    EXPECT_STREQ(outVal, "20 %");
+    printf("%14s %14s\n", "snprintf ns", "writer ns");
+    printf("%14.1f %14.1f\n", printf_ns, writer_ns);
+}
+
+TEST(Benchmark, GroupedOutputsShortenTheReview) {
+    const uint32_t n_destinations = 4;
+    const std::vector<uint8_t> blob = build_base_tx(MAX_OUTPUTS, 1, n_destinations);
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+
+    // Every item of the review, as the user walks through it; the expert mode hash is left out
+    auto walk = [&](bool expert, uint8_t *numItems) {
+        app_mode_set_expert(expert);
+        EXPECT_EQ(parser_parse(&ctx, blob.data(), blob.size(), &tx_obj), parser_ok);
+        EXPECT_EQ(parser_getNumItems(&ctx, numItems), parser_ok);
+        const uint8_t shown = expert ? *numItems - 1 : *numItems;
+        return best_ns(
+            [&](uint32_t) {
+                char outKey[40];
+                char outVal[40];
+                uint8_t pageCount = 0;
+                for (uint8_t idx = 0; idx < shown; idx++) {
+                    _getItemFlr(&ctx, idx, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount);
+                }
+            },
+            kBenchIterations / 10);
+    };
+
+    uint8_t outputs_items = 0;
+    uint8_t grouped_items = 0;
+    const double outputs_ns = walk(true, &outputs_items);
+    const double grouped_ns = walk(false, &grouped_items);
+    app_mode_set_expert(false);
+
+    printf("%8s %8s %14s %14s %14s %14s\n", "outputs", "dests", "output items", "grouped items", "outputs ns",
+           "grouped ns");
+    printf("%8u %8u %14u %14u %14.1f %14.1f\n", (uint32_t)MAX_OUTPUTS, n_destinations, outputs_items - 1U,
+           grouped_items, outputs_ns, grouped_ns);
+
+    // Send, an amount and an address per destination, and the fee
+    EXPECT_EQ(grouped_items, 2 + 2 * n_destinations);
+}
+
+// Operation counts per request over neighbouring indices m/44'/60'/0'/0/i, deriving from the seed
+// and through the cached parent. On device the point multiplications dominate the cost: GET_ADDR
+// adds one for the public key, signing one for the nonce point, which the shim does not see.
+TEST(Benchmark, Bip32CacheDerivesNeighbouringKeys) {
+    constexpr uint32_t kRequests = 20;
+
+    auto run = [](bool cached, bool get_addr) {
+        uint32_t path[] = {BIP32_HARDENED | 44, BIP32_HARDENED | 60, BIP32_HARDENED | 0, 0, 0};
+        const uint32_t path_len = sizeof(path) / sizeof(path[0]);
+        uint8_t key[BIP32_KEY_LEN];
+        uint8_t pubkey[BIP32_PUBKEY_LEN];
+
+        bip32_cache_wipe();
+        bip32_shim_reset();
+        for (uint32_t index = 0; index < kRequests; index++) {
+            path[path_len - 1] = index;
+            const zxerr_t err = cached ? bip32_cache_derive(path, path_len, key, nullptr)
+                                       : bip32_derive_node(path, path_len, key, nullptr);
+            EXPECT_EQ(err, zxerr_ok);
+            if (get_addr) {
+                EXPECT_EQ(bip32_public_key(key, pubkey), zxerr_ok);
+            } else {
+                bip32_shim_counts.point_mul++;
+            }
+        }
+        bip32_cache_wipe();
+        return bip32_shim_counts;
+    };
+
+    printf("%10s %10s %10s %10s %10s %10s\n", "request", "engine", "hmac", "point mul", "scalar add", "speedup");
+    for (bool get_addr : {true, false}) {
+        const bip32_shim_ops seed = run(false, get_addr);
+        const bip32_shim_ops cached = run(true, get_addr);
+        const char *request = get_addr ? "GET_ADDR" : "SIGN";
+        const double speedup = static_cast<double>(seed.point_mul) / cached.point_mul;
+        printf("%10s %10s %10.2f %10.2f %10.2f %10s\n", request, "seed", 1.0 * seed.hmac / kRequests,
+               1.0 * seed.point_mul / kRequests, 1.0 * seed.scalar_add / kRequests, "");
+        printf("%10s %10s %10.2f %10.2f %10.2f %9.1fx\n", request, "cached", 1.0 * cached.hmac / kRequests,
+               1.0 * cached.point_mul / kRequests, 1.0 * cached.scalar_add / kRequests, speedup);
+
+        // Master node and 5 levels per request, 2 of them non-hardened, plus the request's own
+        EXPECT_EQ(seed.hmac, 6 * kRequests);
+        EXPECT_EQ(seed.point_mul, 3 * kRequests);
+        // The parent is built once, with its public key; then one HMAC and addition per request
+        EXPECT_EQ(cached.seed_derivations, 1U);
+        EXPECT_EQ(cached.hmac, 5 + kRequests);
+        EXPECT_EQ(cached.point_mul, 2 + kRequests);
+        EXPECT_GT(speedup, 2.5);
+    }
+}
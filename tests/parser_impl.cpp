@@ -18,18 +18,36 @@
 #include <string.h>
 
 #include <cstdint>
+#include <random>
 #include <string>
+#include <vector>
 
+#include "addr_batch.h"
+#include "app_mode.h"
+#include "base58.h"
 #include "bech32.h"
+#include "bech32_address.h"
+#include "bip32_cache.h"
 #include "coin.h"
 #include "crypto_helper.h"
+#include "evm_number.h"
+#include "evm_utils.h"
 #include "gtest/gtest.h"
 #include "hexutils.h"
+#include "networks.h"
 #include "parser.h"
+#include "parser_codec.h"
 #include "parser_common.h"
+#include "parser_display.h"
+#include "parser_impl_common.h"
+#include "parser_print_common.h"
 #include "parser_txdef.h"
+#include "timeutils.h"
 #include "segwit_addr.h"
 #include "zxerror.h"
+#include "zxformat.h"
+#include "utils/bip32_shim.h"
+#include "utils/tx_builder.h"
 
 extern "C" {
 #include "ripemd160.h"
@@ -129,3 +147,898 @@ TEST(Address, CostonAddress) {
     const std::string flare_address(address, address + strnlen(address, sizeof(address)));
     EXPECT_EQ(flare_address, "costwo1yh62d5xdyzu5w2nc6qpyymsjzqc5qzaurksye9");
 }
+
+TEST(Address, FixedLengthBech32MatchesGenericEncoder) {
+    std::mt19937_64 rng(0xbec32);
+    const char *custom_hrps[] = {"a", "avax", "fuji", "local", "custom!~"};
+
+    for (uint8_t n = 0; n <= coston2; n++) {
+        const network_info_t *network = network_get((network_id_e)n);
+        ASSERT_NE(network, nullptr);
+        uint32_t state = 0;
+        ASSERT_EQ(bech32_hrp_state(network->hrp, strlen(network->hrp), &state), zxerr_ok);
+        EXPECT_EQ(network->hrp_state, state) << network->hrp;
+    }
+
+    uint8_t address[ADDRESS_LEN] = {0};
+    char expected[100];
+    char actual[100];
+    for (int i = 0; i < 2000; i++) {
+        for (auto &b : address) {
+            b = static_cast<uint8_t>(rng());
+        }
+        for (const char *hrp : custom_hrps) {
+            const uint8_t hrp_len = strlen(hrp);
+            uint32_t state = 0;
+            ASSERT_EQ(bech32_hrp_state(hrp, hrp_len, &state), zxerr_ok);
+            ASSERT_EQ(bech32EncodeFromBytes(expected, sizeof(expected), hrp, address, ADDRESS_LEN, 1,
+                                            BECH32_ENCODING_BECH32),
+                      zxerr_ok);
+            ASSERT_EQ(bech32_encode_address(actual, sizeof(actual), hrp, hrp_len, state, address), zxerr_ok);
+            ASSERT_STREQ(actual, expected);
+        }
+
+        // Screens of every network go through the precomputed hrp state
+        const network_id_e network_id = (network_id_e)(i % (coston2 + 1));
+        const network_info_t *network = network_get(network_id);
+        uint8_t pageCount = 0;
+        ASSERT_EQ(printAddress(address, network_id, actual, sizeof(actual), 0, &pageCount), parser_ok);
+        ASSERT_EQ(
+            bech32EncodeFromBytes(expected, sizeof(expected), network->hrp, address, ADDRESS_LEN, 1, BECH32_ENCODING_BECH32),
+            zxerr_ok);
+        ASSERT_STREQ(actual, expected);
+    }
+
+    uint32_t state = 0;
+    EXPECT_EQ(bech32_hrp_state("Flare", 5, &state), zxerr_encoding_failed);
+    EXPECT_EQ(bech32_hrp_state("fl are", 6, &state), zxerr_encoding_failed);
+    ASSERT_EQ(bech32_hrp_state("flare", 5, &state), zxerr_ok);
+    EXPECT_EQ(bech32_encode_address(actual, BECH32_ADDRESS_STR_LEN(5), "flare", 5, state, address), zxerr_buffer_too_small);
+}
+
+static parser_error_t parse_partial(const std::string &hex) {
+    uint8_t buffer[200] = {0};
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), hex.c_str());
+
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    return parser_parse_chunk(&ctx, buffer, bufferLen, &tx_obj, false);
+}
+
+namespace {
+std::vector<uint32_t> batch_filled;
+uint32_t batch_fail_at = UINT32_MAX;
+
+// Stand-in for the device derivation: pubkey and address tagged with the address index
+zxerr_t fake_batch_fill(const uint32_t *path, uint32_t path_len, uint8_t *pubkey, char *address, uint16_t addressLen) {
+    if (path_len != HDPATH_LEN_DEFAULT) {
+        return zxerr_invalid_crypto_settings;
+    }
+    const uint32_t index = path[path_len - 1];
+    if (index == batch_fail_at) {
+        return zxerr_encoding_failed;
+    }
+    batch_filled.push_back(index);
+    memset(pubkey, (uint8_t)index, PK_LEN_SECP256K1);
+    pubkey[0] = 0x02;
+    memset(address, 'a' + index % 26, addressLen);
+    return zxerr_ok;
+}
+
+// m/44'/60'/0'/0/index
+const uint32_t *batch_path(uint32_t index) {
+    static uint32_t path[HDPATH_LEN_DEFAULT];
+    const uint32_t base[HDPATH_LEN_DEFAULT] = {0x80000000u | 44, 0x80000000u | 60, 0x80000000u, 0, index};
+    memcpy(path, base, sizeof(path));
+    return path;
+}
+
+std::vector<uint32_t> batch_accounts;
+
+zxerr_t recording_batch_fill(const uint32_t *path, uint32_t path_len, uint8_t *pubkey, char *address,
+                             uint16_t addressLen) {
+    batch_accounts.push_back(path[2]);
+    return fake_batch_fill(path, path_len, pubkey, address, addressLen);
+}
+}  // namespace
+
+TEST(AddressBatch, RepliesArePackedAndContinue) {
+    const uint8_t hrp_len = 5;  // "flare"
+    const uint16_t entry_len = addr_batch_entry_len(hrp_len);
+    ASSERT_EQ(entry_len, PK_LEN_SECP256K1 + 1 + 44);
+
+    // 260-byte APDU buffer minus the status word holds 3 entries
+    addr_batch_t batch;
+    uint8_t reply[258];
+    ASSERT_EQ(addr_batch_start(&batch, batch_path(7), 10, hrp_len), zxerr_ok);
+    batch_filled.clear();
+
+    uint32_t expected_index = 7;
+    for (uint8_t expected_remaining : {7, 4, 1, 0}) {
+        uint16_t replyLen = 0;
+        ASSERT_EQ(addr_batch_pack(&batch, fake_batch_fill, reply, sizeof(reply), &replyLen), zxerr_ok);
+        const uint8_t n_entries = reply[0];
+        EXPECT_EQ(n_entries, expected_remaining ? 3 : 1);
+        EXPECT_EQ(reply[1], expected_remaining);
+        ASSERT_EQ(replyLen, ADDR_BATCH_HEADER_LEN + n_entries * entry_len);
+
+        for (uint8_t i = 0; i < n_entries; i++, expected_index++) {
+            const uint8_t *entry = reply + ADDR_BATCH_HEADER_LEN + i * entry_len;
+            EXPECT_EQ(entry[0], 0x02);
+            EXPECT_EQ(entry[1], (uint8_t)expected_index);
+            EXPECT_EQ(entry[PK_LEN_SECP256K1], 44);
+            EXPECT_EQ(entry[PK_LEN_SECP256K1 + 1], 'a' + expected_index % 26);
+            EXPECT_EQ(entry[entry_len - 1], 'a' + expected_index % 26);
+        }
+    }
+    EXPECT_EQ(expected_index, 17U);
+    EXPECT_EQ(batch_filled.size(), 10U);
+
+    // Nothing left to continue with
+    uint16_t replyLen = 0;
+    EXPECT_EQ(addr_batch_pack(&batch, fake_batch_fill, reply, sizeof(reply), &replyLen), zxerr_no_data);
+    EXPECT_EQ(replyLen, 0);
+
+    // A reply must fit at least one entry
+    ASSERT_EQ(addr_batch_start(&batch, batch_path(0), 1, hrp_len), zxerr_ok);
+    EXPECT_EQ(addr_batch_pack(&batch, fake_batch_fill, reply, ADDR_BATCH_HEADER_LEN + entry_len - 1, &replyLen),
+              zxerr_buffer_too_small);
+    EXPECT_EQ(addr_batch_pack(&batch, fake_batch_fill, reply, ADDR_BATCH_HEADER_LEN + entry_len, &replyLen), zxerr_ok);
+    EXPECT_EQ(replyLen, ADDR_BATCH_HEADER_LEN + entry_len);
+
+    // A failed derivation drops the whole reply
+    batch_fail_at = 2;
+    ASSERT_EQ(addr_batch_start(&batch, batch_path(0), 3, hrp_len), zxerr_ok);
+    EXPECT_EQ(addr_batch_pack(&batch, fake_batch_fill, reply, sizeof(reply), &replyLen), zxerr_encoding_failed);
+    EXPECT_EQ(replyLen, 0);
+    EXPECT_EQ(reply[0], 0);
+    batch_fail_at = UINT32_MAX;
+
+    // Indices stay below the hardened range, and a batch is never empty
+    EXPECT_EQ(addr_batch_start(&batch, batch_path(0x7fffffff), 1, hrp_len), zxerr_ok);
+    EXPECT_EQ(addr_batch_start(&batch, batch_path(0x7fffffff), 2, hrp_len), zxerr_out_of_bounds);
+    EXPECT_EQ(addr_batch_start(&batch, batch_path(0x80000000), 1, hrp_len), zxerr_out_of_bounds);
+    EXPECT_EQ(addr_batch_start(&batch, batch_path(0), 0, hrp_len), zxerr_out_of_bounds);
+}
+
+// A signing request between two batch replies sets the app path; the batch
+// must keep deriving from its own path and never write to the caller's.
+TEST(AddressBatch, SigningBetweenRepliesKeepsItsPath) {
+    const uint8_t hrp_len = 5;
+    uint32_t app_path[HDPATH_LEN_DEFAULT];
+    memcpy(app_path, batch_path(3), sizeof(app_path));
+
+    addr_batch_t batch;
+    uint8_t reply[258];
+    uint16_t replyLen = 0;
+    ASSERT_EQ(addr_batch_start(&batch, app_path, 6, hrp_len), zxerr_ok);
+    batch_filled.clear();
+    batch_accounts.clear();
+    ASSERT_EQ(addr_batch_pack(&batch, recording_batch_fill, reply, sizeof(reply), &replyLen), zxerr_ok);
+
+    // INS_SIGN P1_INIT for another account
+    const uint32_t signing_path[HDPATH_LEN_DEFAULT] = {0x80000000u | 44, 0x80000000u | 60, 0x80000001u, 0, 9};
+    memcpy(app_path, signing_path, sizeof(app_path));
+
+    ASSERT_EQ(addr_batch_pack(&batch, recording_batch_fill, reply, sizeof(reply), &replyLen), zxerr_ok);
+    EXPECT_EQ(reply[1], 0);
+    EXPECT_EQ(memcmp(app_path, signing_path, sizeof(app_path)), 0);
+
+    EXPECT_EQ(batch_filled, std::vector<uint32_t>({3, 4, 5, 6, 7, 8}));
+    EXPECT_EQ(batch_accounts, std::vector<uint32_t>(6, 0x80000000u));
+}
+
+TEST(Bip32Cache, ChildrenMatchDerivationFromTheSeed) {
+    uint32_t path[] = {BIP32_HARDENED | 44, BIP32_HARDENED | 60, BIP32_HARDENED | 0, 0, 0};
+    const uint32_t path_len = sizeof(path) / sizeof(path[0]);
+    uint8_t key[BIP32_KEY_LEN];
+    uint8_t chain[BIP32_CHAIN_CODE_LEN];
+    uint8_t expected_key[BIP32_KEY_LEN];
+    uint8_t expected_chain[BIP32_CHAIN_CODE_LEN];
+
+    auto expect_same_as_seed = [&]() {
+        ASSERT_EQ(bip32_cache_derive(path, path_len, key, chain), zxerr_ok);
+        ASSERT_EQ(bip32_derive_node(path, path_len, expected_key, expected_chain), zxerr_ok);
+        EXPECT_EQ(memcmp(key, expected_key, sizeof(key)), 0);
+        EXPECT_EQ(memcmp(chain, expected_chain, sizeof(chain)), 0);
+    };
+
+    // Neighbouring indices reach the seed once, for the parent
+    bip32_cache_wipe();
+    bip32_shim_reset();
+    for (uint32_t index = 0; index < 5; index++) {
+        path[path_len - 1] = index;
+        const uint32_t seed_derivations = bip32_shim_counts.seed_derivations;
+        expect_same_as_seed();
+        EXPECT_EQ(bip32_shim_counts.seed_derivations - seed_derivations, index == 0 ? 2U : 1U);
+    }
+
+    // Another parent rebuilds the cache
+    path[2] = BIP32_HARDENED | 1;
+    bip32_shim_reset();
+    expect_same_as_seed();
+    EXPECT_EQ(bip32_shim_counts.seed_derivations, 2U);
+
+    // Hardened children come straight from the seed
+    const uint32_t account[] = {BIP32_HARDENED | 44, BIP32_HARDENED | 60, BIP32_HARDENED | 0};
+    ASSERT_EQ(bip32_cache_derive(account, 3, key, chain), zxerr_ok);
+    ASSERT_EQ(bip32_derive_node(account, 3, expected_key, expected_chain), zxerr_ok);
+    EXPECT_EQ(memcmp(key, expected_key, sizeof(key)), 0);
+
+    // A failure zeroes the outputs and drops the cached parent
+    path[2] = BIP32_HARDENED | 0;
+    expect_same_as_seed();
+    bip32_shim_reset();
+    bip32_shim_fail_hmac = 0;
+    EXPECT_NE(bip32_cache_derive(path, path_len, key, chain), zxerr_ok);
+    bip32_shim_fail_hmac = UINT32_MAX;
+    const uint8_t zeros[BIP32_KEY_LEN] = {0};
+    EXPECT_EQ(memcmp(key, zeros, sizeof(key)), 0);
+    EXPECT_EQ(memcmp(chain, zeros, sizeof(chain)), 0);
+    bip32_shim_reset();
+    expect_same_as_seed();
+    EXPECT_EQ(bip32_shim_counts.seed_derivations, 2U);
+
+    // Paths the engine cannot take
+    EXPECT_EQ(bip32_cache_derive(path, 0, key, chain), zxerr_invalid_crypto_settings);
+    EXPECT_EQ(bip32_cache_derive(path, MAX_BIP32_PATH + 1, key, chain), zxerr_invalid_crypto_settings);
+    bip32_cache_wipe();
+}
+
+TEST(Stream, IncompleteChunkIsAccepted) {
+    EXPECT_EQ(parse_partial(std::string(kBaseTxPrefix).substr(0, 14)), parser_ok);
+    EXPECT_EQ(parse_partial(std::string(kBaseTxPrefix) + "00000001" + "1111"), parser_ok);
+}
+
+TEST(Stream, RejectsOnFirstInvalidChunk) {
+    EXPECT_EQ(parse_partial("0001"), parser_invalid_codec);
+    EXPECT_EQ(parse_partial("0000000000ff"), parser_unknown_transaction);
+    EXPECT_EQ(parse_partial("00000000002200000063"), parser_unexpected_network);
+    EXPECT_EQ(parse_partial(std::string(kBaseTxPrefix) + "00000041"), parser_unexpected_number_items);
+}
+
+TEST(Hash, DisplaysStoredDigest) {
+    // BaseTx without outputs spending a single 1 FLR input
+    const std::string blob = base_tx_hex({}, 1000000000ULL);
+
+    uint8_t buffer[200] = {0};
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), blob.c_str());
+
+    app_mode_set_expert(true);
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    ASSERT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_ok);
+
+    // Without a provided digest the Hash item hashes the buffer once
+    uint8_t expected[TX_HASH_LEN] = {0};
+    ASSERT_EQ(crypto_sha256(buffer, bufferLen, expected, sizeof(expected)), zxerr_ok);
+    ASSERT_EQ(parser_validate(&ctx), parser_ok);
+
+    char outKey[40] = {0};
+    char outVal[40] = {0};
+    uint8_t pageCount = 0;
+    ASSERT_EQ(parser_getItem(&ctx, 2, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount), parser_ok);
+    EXPECT_TRUE(tx_obj.tx_hash_ready);
+    EXPECT_EQ(memcmp(tx_obj.tx_hash, expected, sizeof(expected)), 0);
+
+    // A digest provided by the tx layer is what the Hash item shows
+    uint8_t stored[TX_HASH_LEN];
+    memset(stored, 0xab, sizeof(stored));
+    ASSERT_EQ(parser_set_tx_hash(&ctx, stored, sizeof(stored)), parser_ok);
+    ASSERT_EQ(parser_getItem(&ctx, 2, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount), parser_ok);
+    EXPECT_STREQ(outKey, "Hash");
+    EXPECT_STREQ(outVal, "ababababababababababababababababababab");
+    app_mode_set_expert(false);
+}
+
+extern "C" parser_error_t _getItemFlr(const parser_context_t *ctx, uint8_t displayIdx, char *outKey, uint16_t outKeyLen,
+                                      char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount);
+
+TEST(Signature, DerEncodingOfFixedRS) {
+    auto der = [](const std::string &r, const std::string &s) {
+        uint8_t r_bytes[32], s_bytes[32], out[80];
+        parseHexString(r_bytes, sizeof(r_bytes), r.c_str());
+        parseHexString(s_bytes, sizeof(s_bytes), s.c_str());
+        const uint8_t len = crypto_encodeDER(r_bytes, s_bytes, out, sizeof(out));
+        char hex[2 * sizeof(out) + 1] = {0};
+        array_to_hexstr(hex, sizeof(hex), out, len);
+        return std::string(hex);
+    };
+    const std::string low = "01" + std::string(62, '2');
+    const std::string high = "81" + std::string(62, '2');
+
+    // A positive INTEGER gets a zero in front of a set top bit
+    EXPECT_EQ(der(low, high), "3045" "0220" + low + "022100" + high);
+    // and drops the leading zeros of the fixed width value
+    const std::string tail(58, '2');
+    EXPECT_EQ(der("000080" + tail, std::string(64, '0')), "3024" "021f0080" + tail + "020100");
+    EXPECT_EQ(der("00007f" + tail, low), "3042" "021e7f" + tail + "0220" + low);
+
+    // Longest encoding, and an output buffer one byte short of it
+    uint8_t r_bytes[32], s_bytes[32], out[80];
+    memset(r_bytes, 0xff, sizeof(r_bytes));
+    memset(s_bytes, 0xff, sizeof(s_bytes));
+    EXPECT_EQ(crypto_encodeDER(r_bytes, s_bytes, out, sizeof(out)), 72);
+    EXPECT_EQ(crypto_encodeDER(r_bytes, s_bytes, out, 71), 0);
+}
+
+TEST(ItemCache, PagesMatchDirectRendering) {
+    // BaseTx with one output to two owners, funded by a single input
+    const std::string blob = base_tx_hex({{1000000000ULL, address_hex(0x22) + address_hex(0x44)}}, 2000000000ULL);
+
+    uint8_t buffer[300] = {0};
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), blob.c_str());
+
+    for (bool expert : {false, true}) {
+        app_mode_set_expert(expert);
+        parser_context_t ctx;
+        parser_tx_t tx_obj;
+        memset(&tx_obj, 0, sizeof(tx_obj));
+        ASSERT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_ok);
+        ASSERT_EQ(parser_validate(&ctx), parser_ok);
+
+        uint8_t numItems = 0;
+        ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+
+        // Narrow values force multi-page items; walk the pages forward and then back
+        for (uint8_t idx = 0; idx < numItems; idx++) {
+            char key[40], val[12], expectedKey[40], expectedVal[12];
+            uint8_t pageCount = 0, expectedPageCount = 0;
+            ASSERT_EQ(_getItemFlr(&ctx, idx, expectedKey, sizeof(expectedKey), expectedVal, sizeof(expectedVal), 0,
+                                  &expectedPageCount),
+                      parser_ok);
+
+            for (int step = 0; step < 2 * expectedPageCount; step++) {
+                const uint8_t page = step < expectedPageCount ? step : 2 * expectedPageCount - 1 - step;
+                ASSERT_EQ(_getItemFlr(&ctx, idx, expectedKey, sizeof(expectedKey), expectedVal, sizeof(expectedVal), page,
+                                      &expectedPageCount),
+                          parser_ok);
+                ASSERT_EQ(parser_getItem(&ctx, idx, key, sizeof(key), val, sizeof(val), page, &pageCount), parser_ok);
+                EXPECT_STREQ(key, expectedKey) << "item " << (int)idx << " page " << (int)page;
+                EXPECT_STREQ(val, expectedVal) << "item " << (int)idx << " page " << (int)page;
+                EXPECT_EQ(pageCount, expectedPageCount) << "item " << (int)idx;
+            }
+        }
+    }
+    app_mode_set_expert(false);
+}
+
+TEST(DisplayPlan, CompiledOnceParsingEnds) {
+    // BaseTx with one output to two owners, funded by a single input
+    const std::string blob = base_tx_hex({{1000000000ULL, address_hex(0x22) + address_hex(0x44)}}, 2000000000ULL);
+
+    uint8_t buffer[300] = {0};
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), blob.c_str());
+
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+
+    // Nothing can be shown until the last chunk is in
+    ASSERT_EQ(parser_parse_chunk(&ctx, buffer, bufferLen - 4, &tx_obj, false), parser_ok);
+    uint8_t numItems = 0;
+    EXPECT_EQ(parser_getNumItems(&ctx, &numItems), parser_unexpected_number_items);
+
+    ASSERT_EQ(parser_parse_chunk(&ctx, buffer, bufferLen, &tx_obj, true), parser_ok);
+    const display_plan_t *plan = &tx_obj.display;
+    ASSERT_EQ(plan->n_entries, 4);
+    EXPECT_EQ(plan->entries[0].kind, display_send);
+    EXPECT_EQ(plan->entries[1].kind, display_outputs);
+    EXPECT_EQ(plan->entries[1].count, 3);
+    EXPECT_EQ(plan->entries[2].kind, display_fee);
+    EXPECT_EQ(plan->entries[3].kind, display_hash);
+    EXPECT_EQ(plan->n_items[DISPLAY_VIEW_NORMAL], 5);
+    EXPECT_EQ(plan->n_items[DISPLAY_VIEW_EXPERT], 6);
+
+    // The hash closes the plan and is only counted in expert mode
+    for (bool expert : {false, true}) {
+        app_mode_set_expert(expert);
+        ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+        EXPECT_EQ(numItems, expert ? 6 : 5);
+    }
+    app_mode_set_expert(false);
+
+    display_kind_e kind = display_send;
+    uint8_t itemIdx = 0;
+    ASSERT_EQ(parser_display_lookup(&tx_obj, 3, &kind, &itemIdx), parser_ok);
+    EXPECT_EQ(kind, display_outputs);
+    EXPECT_EQ(itemIdx, 2);
+    ASSERT_EQ(parser_display_lookup(&tx_obj, 4, &kind, &itemIdx), parser_ok);
+    EXPECT_EQ(kind, display_fee);
+    EXPECT_EQ(parser_display_lookup(&tx_obj, 5, &kind, &itemIdx), parser_display_idx_out_of_range);
+
+    // Each view walks only the entries it shows
+    app_mode_set_expert(true);
+    ASSERT_EQ(parser_display_lookup(&tx_obj, 5, &kind, &itemIdx), parser_ok);
+    EXPECT_EQ(kind, display_hash);
+    EXPECT_EQ(itemIdx, 0);
+    EXPECT_EQ(parser_display_lookup(&tx_obj, 6, &kind, &itemIdx), parser_display_idx_out_of_range);
+    app_mode_set_expert(false);
+}
+
+TEST(ChangeOutputs, HiddenOutsideExpertMode) {
+    const std::string change = address_hex(0xcc);
+    // Change, a payment, and an output the wallet shares with another owner
+    const std::string hex =
+        base_tx_hex({{0x10, change}, {0x20, address_hex(0xdd)}, {0x30, change + address_hex(0xee)}}, 0x70);
+
+    uint8_t buffer[600] = {0};
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), hex.c_str());
+    uint8_t change_address[ADDRESS_LEN] = {0};
+    parseHexString(change_address, sizeof(change_address), change.c_str());
+
+    auto review = [&](bool hide_change, bool expert) {
+        app_mode_set_expert(expert);
+        EXPECT_EQ(parser_set_change_address(hide_change ? change_address : NULL, ADDRESS_LEN), parser_ok);
+
+        parser_context_t ctx;
+        parser_tx_t tx_obj;
+        memset(&tx_obj, 0, sizeof(tx_obj));
+        std::vector<std::string> items;
+        EXPECT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_ok);
+        EXPECT_EQ(parser_validate(&ctx), parser_ok);
+        uint8_t numItems = 0;
+        EXPECT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+        for (uint8_t idx = 0; idx < numItems; idx++) {
+            char key[40], val[100];
+            uint8_t pageCount = 0;
+            EXPECT_EQ(parser_getItem(&ctx, idx, key, sizeof(key), val, sizeof(val), 0, &pageCount), parser_ok);
+            items.push_back(std::string(key) + " : " + val);
+        }
+        return items;
+    };
+
+    const std::vector<std::string> all = review(false, false);
+    ASSERT_EQ(all.size(), 9U);
+    const std::string changeAmount = all[1].substr(all[1].find(" : "));
+    const std::string changeOwner = all[2];
+
+    const std::vector<std::string> hidden = review(true, false);
+    ASSERT_EQ(hidden.size(), 7U);
+    EXPECT_EQ(hidden[0], all[0]);
+    EXPECT_EQ(std::vector<std::string>(hidden.begin() + 1, hidden.end()),
+              std::vector<std::string>(all.begin() + 3, all.end()));
+
+    // Expert mode lists the change after the other outputs
+    const std::vector<std::string> expert = review(true, true);
+    ASSERT_EQ(expert.size(), 10U);
+    EXPECT_EQ(std::vector<std::string>(expert.begin(), expert.begin() + 6),
+              std::vector<std::string>(hidden.begin(), hidden.begin() + 6));
+    EXPECT_EQ(expert[6], "Change" + changeAmount);
+    EXPECT_EQ(expert[7], changeOwner);
+    EXPECT_EQ(expert[8], hidden[6]);
+    EXPECT_EQ(expert[9].substr(0, 4), "Hash");
+
+    app_mode_set_expert(false);
+    parser_set_change_address(NULL, 0);
+}
+
+TEST(OutputGroups, SumPerDestinationOutsideExpertMode) {
+    const std::string a = address_hex(0xaa);
+    const std::string b = address_hex(0xbb);
+    // Two outputs to a, two to b, and one that a and b share
+    const std::string hex = base_tx_hex({{0x10, a}, {0x20, b}, {0x30, a}, {0x40, a + b}, {0x50, b}}, 0x100);
+
+    uint8_t buffer[800] = {0};
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), hex.c_str());
+
+    auto review = [&](bool expert, parser_tx_t *tx_obj) {
+        app_mode_set_expert(expert);
+        parser_context_t ctx;
+        memset(tx_obj, 0, sizeof(*tx_obj));
+        std::vector<std::string> items;
+        EXPECT_EQ(parser_parse(&ctx, buffer, bufferLen, tx_obj), parser_ok);
+        EXPECT_EQ(parser_validate(&ctx), parser_ok);
+        uint8_t numItems = 0;
+        EXPECT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+        for (uint8_t idx = 0; idx < numItems; idx++) {
+            char key[40], val[100];
+            uint8_t pageCount = 0;
+            EXPECT_EQ(parser_getItem(&ctx, idx, key, sizeof(key), val, sizeof(val), 0, &pageCount), parser_ok);
+            items.push_back(std::string(key) + " : " + val);
+        }
+        return items;
+    };
+    auto amount = [](uint64_t value) {
+        char val[100];
+        uint8_t pageCount = 0;
+        EXPECT_EQ(printAmount64(value, AMOUNT_DECIMAL_PLACES, mainnet, val, sizeof(val), 0, &pageCount), parser_ok);
+        return std::string("Amount : ") + val;
+    };
+
+    parser_tx_t tx_obj;
+    const std::vector<std::string> expert = review(true, &tx_obj);
+    ASSERT_EQ(expert.size(), 14U);
+    EXPECT_EQ(tx_obj.out_groups.n_groups, 3);
+    EXPECT_EQ(expert[1], amount(0x10));
+    EXPECT_EQ(expert[5], amount(0x30));
+    const std::string ownerA = expert[2];
+    const std::string ownerB = expert[4];
+    EXPECT_EQ(expert[8], ownerA);
+    EXPECT_EQ(expert[9], ownerB);
+
+    const std::vector<std::string> grouped = review(false, &tx_obj);
+    const std::vector<std::string> expected = {expert[0], amount(0x40), ownerA, amount(0x70), ownerB,
+                                               amount(0x40), ownerA, ownerB, expert[12]};
+    EXPECT_EQ(grouped, expected);
+
+    // Grouping moves no value: the group totals add up to what the outputs pay
+    uint64_t total = 0;
+    for (uint8_t g = 0; g < tx_obj.out_groups.n_groups; g++) {
+        total += tx_obj.out_groups.amount[g];
+    }
+    EXPECT_EQ(total, tx_obj.summary.total_out);
+    EXPECT_EQ(total, 0xF0U);
+
+
+    app_mode_set_expert(false);
+}
+
+TEST(Codec, DecodesFixedRunsAndArrays) {
+    enum { slot_amount, slot_items };
+    static const codec_field_t fields[] = {
+        CODEC_SKIP(2),
+        CODEC_TYPE_ID(SECP_TYPE_ID),
+        CODEC_U64(slot_amount),
+        CODEC_ARRAY(2, 3, slot_items),
+        CODEC_SKIP(1),
+    };
+    static const codec_schema_t schema = CODEC_SCHEMA(fields);
+
+    uint8_t buffer[40] = {0};
+    const uint16_t bufferLen =
+        parseHexString(buffer, sizeof(buffer), "ffff" "00000007" "0102030405060708" "00000002" "aaaabbbb" "cc");
+
+    parser_context_t ctx = {buffer, bufferLen, 0, NULL};
+    codec_record_t record;
+    ASSERT_EQ(codec_decode(&ctx, &schema, &record), parser_ok);
+    EXPECT_EQ(ctx.offset, bufferLen);
+    EXPECT_EQ(record.value[slot_amount], 0x0102030405060708ULL);
+    EXPECT_EQ(record.offset[slot_amount], 6);
+    EXPECT_EQ(record.value[slot_items], 2U);
+    EXPECT_EQ(record.offset[slot_items], 18);
+
+    // Truncated anywhere, including inside the array or the trailing run
+    for (uint16_t len = 0; len < bufferLen; len++) {
+        parser_context_t short_ctx = {buffer, len, 0, NULL};
+        EXPECT_EQ(codec_decode(&short_ctx, &schema, &record), parser_unexpected_buffer_end) << len;
+    }
+
+    // Wrong type id and too many array elements
+    buffer[5] = 0x05;
+    ctx.offset = 0;
+    EXPECT_EQ(codec_decode(&ctx, &schema, &record), parser_unexpected_type_id);
+    buffer[5] = 0x07;
+    buffer[17] = 0x04;
+    ctx.offset = 0;
+    EXPECT_EQ(codec_decode(&ctx, &schema, &record), parser_unexpected_number_items);
+}
+
+TEST(Summary, FeeIsDerivedAndCheckedAtParseTime) {
+    // BaseTx paying 1 FLR out of a single input of input_amount
+    auto base_tx = [](uint64_t input_amount) { return base_tx_hex({{1000000000ULL, address_hex(0x22)}}, input_amount); };
+
+    uint8_t buffer[300] = {0};
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+
+    uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), base_tx(2000000000ULL).c_str());
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    ASSERT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_ok);
+    EXPECT_EQ(tx_obj.summary.total_in, 2000000000ULL);
+    EXPECT_EQ(tx_obj.summary.total_out, 1000000000ULL);
+    EXPECT_EQ(tx_obj.summary.staked, 0ULL);
+    EXPECT_EQ(tx_obj.summary.fee, 1000000000ULL);
+    EXPECT_EQ(tx_obj.summary.n_outputs, 1);
+
+    // Outputs exceeding inputs are rejected before anything is displayed
+    bufferLen = parseHexString(buffer, sizeof(buffer), base_tx(999999999ULL).c_str());
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    EXPECT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_unexpected_error);
+}
+
+TEST(Networks, RegistryResolvesThroughTheParsedNetwork) {
+    for (network_id_e network : {mainnet, songbird, coston, coston2}) {
+        const network_info_t *info = network_get(network);
+        ASSERT_NE(info, nullptr);
+
+        network_id_e resolved = mainnet;
+        ASSERT_EQ(network_from_id(info->network_id, &resolved), parser_ok);
+        EXPECT_EQ(resolved, network);
+        ASSERT_EQ(network_from_evm_chain_id(info->evm_chain_id, &resolved), parser_ok);
+        EXPECT_EQ(resolved, network);
+
+        chain_id_e chain = p_chain;
+        char alias = 0;
+        ASSERT_EQ(network_chain_lookup(network, info->c_chain_id, &chain, &alias), parser_ok);
+        EXPECT_EQ(chain, c_chain);
+        EXPECT_EQ(alias, 'C');
+
+        const uint8_t p_chain_id[BLOCKCHAIN_ID_LEN] = {0};
+        ASSERT_EQ(network_chain_lookup(network, p_chain_id, &chain, &alias), parser_ok);
+        EXPECT_EQ(chain, p_chain);
+        EXPECT_EQ(alias, 'P');
+
+        // The C-chain of another network is not a chain of this one
+        const network_id_e other = network == mainnet ? coston2 : mainnet;
+        EXPECT_EQ(network_chain_lookup(network, network_get(other)->c_chain_id, &chain, &alias), parser_unexpected_chain);
+    }
+
+    network_id_e resolved = mainnet;
+    EXPECT_EQ(network_from_id(1, &resolved), parser_unexpected_network);
+    EXPECT_EQ(network_from_evm_chain_id(1, &resolved), parser_invalid_chain_id);
+    EXPECT_EQ(network_get((network_id_e)4), nullptr);
+}
+
+TEST(Layout, ParsedTxStaysWithinItsBudget) {
+    // No pointers are stored, so the host size is the size on every target
+    EXPECT_LE(sizeof(parser_tx_t), (size_t)PARSER_TX_MAX_SIZE_LIGHT);
+    EXPECT_LE(sizeof(parser_tx_t), (size_t)PARSER_TX_MAX_SIZE_FULL);
+
+    // BaseTx with an output paying to two addresses and one paying to three
+    // Owners whose addresses end in their index
+    auto owners = [](uint32_t n_addrs, char addr) {
+        std::string addrs;
+        for (uint32_t i = 0; i < n_addrs; i++) {
+            addrs += std::string(39, addr) + std::to_string(i);
+        }
+        return addrs;
+    };
+    const std::string hex = base_tx_hex({{5, owners(2, 'a')}, {7, owners(3, 'b')}}, 0x10);
+
+    uint8_t buffer[600] = {0};
+    parser_context_t ctx;
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), hex.c_str());
+    ASSERT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_ok);
+    EXPECT_EQ(tx_obj.tx.base_tx.base_secp_outs.n_outs, 2);
+    EXPECT_EQ(tx_obj.tx.base_tx.base_secp_outs.n_addrs, 5);
+    ASSERT_EQ(tx_obj.out_index.n_items, 7);
+
+    const struct {
+        uint8_t element_idx;
+        uint64_t amount;
+        char addr;
+        char last;
+    } expected[] = {{0, 5, 0, 0}, {1, 0, 'a', '0'}, {1, 0, 'a', '1'}, {0, 7, 0, 0},
+                    {1, 0, 'b', '0'}, {1, 0, 'b', '1'}, {1, 0, 'b', '2'}};
+    for (uint8_t i = 0; i < 7; i++) {
+        uint64_t amount = 0;
+        uint8_t address[ADDRESS_LEN] = {0};
+        uint8_t element_idx = 0;
+        ASSERT_EQ(parser_get_output_item(&ctx, i, &amount, address, &element_idx), parser_ok);
+        EXPECT_EQ(element_idx, expected[i].element_idx) << "item " << (int)i;
+        if (element_idx == 0) {
+            EXPECT_EQ(amount, expected[i].amount) << "item " << (int)i;
+        } else {
+            uint8_t expected_address[ADDRESS_LEN] = {0};
+            const std::string expected_hex = std::string(39, expected[i].addr) + expected[i].last;
+            parseHexString(expected_address, sizeof(expected_address), expected_hex.c_str());
+            EXPECT_EQ(memcmp(address, expected_address, ADDRESS_LEN), 0) << "item " << (int)i;
+        }
+    }
+    uint64_t amount = 0;
+    uint8_t address[ADDRESS_LEN] = {0};
+    uint8_t element_idx = 0;
+    EXPECT_EQ(parser_get_output_item(&ctx, 7, &amount, address, &element_idx), parser_unexpected_number_items);
+}
+
+// printAmount64 as it used to be written: zxformat conversions and in-place trimming
+static void legacy_amount64(uint64_t amount, const char *ticker, char *out, size_t outLen) {
+    char strAmount[33] = {0};
+    ASSERT_EQ(uint64_to_str(strAmount, sizeof(strAmount), amount), nullptr);
+    ASSERT_NE(intstr_to_fpstr_inplace(strAmount, sizeof(strAmount), AMOUNT_DECIMAL_PLACES), 0U);
+    number_inplace_trimming(strAmount, 1);
+    char *point = strchr(strAmount, '.');
+    if (point != nullptr && strspn(point + 1, "0") == strlen(point + 1)) {
+        *point = '\0';
+    }
+    z_str3join(strAmount, sizeof(strAmount), "", " ");
+    z_str3join(strAmount, sizeof(strAmount), "", ticker);
+    snprintf(out, outLen, "%s", strAmount);
+}
+
+TEST(Amount, MatchesLegacyFormatting) {
+    std::vector<uint64_t> amounts = {0, 1, UINT64_MAX, UINT64_MAX - 1, UINT64_MAX / 10, 1000000001ULL, 1234567890ULL};
+    uint64_t pow10 = 1;
+    for (int k = 0; k < 20; k++, pow10 *= 10) {
+        for (uint64_t m : {1ULL, 3ULL, 9ULL}) {
+            if (pow10 <= UINT64_MAX / m) {
+                amounts.push_back(m * pow10);
+                amounts.push_back(m * pow10 - 1);
+                amounts.push_back(m * pow10 + 1);
+            }
+        }
+    }
+    for (uint64_t v = 0; v < 100000; v++) {
+        amounts.push_back(v);
+    }
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Spread the values over every magnitude
+        amounts.push_back(seed >> (seed % 64));
+    }
+
+    for (network_id_e network : {mainnet, songbird, coston, coston2}) {
+        for (uint64_t amount : amounts) {
+            char expected[40];
+            legacy_amount64(amount, network_get(network)->ticker, expected, sizeof(expected));
+
+            char outVal[40];
+            uint8_t pageCount = 0;
+            ASSERT_EQ(printAmount64(amount, AMOUNT_DECIMAL_PLACES, network, outVal, sizeof(outVal), 0, &pageCount),
+                      parser_ok);
+            ASSERT_STREQ(outVal, expected) << amount;
+            ASSERT_EQ(pageCount, 1);
+        }
+    }
+
+    // Paging slices the same string
+    char outVal[9];
+    uint8_t pageCount = 0;
+    ASSERT_EQ(printAmount64(UINT64_MAX, AMOUNT_DECIMAL_PLACES, mainnet, outVal, sizeof(outVal), 2, &pageCount), parser_ok);
+    EXPECT_EQ(pageCount, 4);
+    EXPECT_STREQ(outVal, "51615 FL");
+}
+
+TEST(EvmNumber, MatchesRLPAndFixedPointPrinting) {
+    std::mt19937_64 rng(0x5eed);
+    uint8_t number[EVM_NUMBER_MAX_LEN] = {0};
+    char expected[100];
+    char actual[100];
+    uint8_t pageCount = 0;
+
+    for (int i = 0; i < 20000; i++) {
+        // Every width up to 256 bits, minimally encoded as RLP integers are
+        const uint16_t len = rng() % (EVM_NUMBER_MAX_LEN + 1);
+        for (uint16_t j = 0; j < len; j++) {
+            number[j] = static_cast<uint8_t>(rng());
+        }
+        if (len > 0 && number[0] == 0) {
+            number[0] = 1;
+        }
+
+        rlp_t rlp;
+        memset(&rlp, 0, sizeof(rlp));
+        rlp.kind = RLP_KIND_STRING;
+        rlp.ptr = number;
+        rlp.rlpLen = len;
+        ASSERT_EQ(printRLPNumber(&rlp, expected, sizeof(expected), 0, &pageCount), parser_ok);
+        ASSERT_EQ(printEvmNumber(number, len, 0, NULL, actual, sizeof(actual), 0, &pageCount), parser_ok);
+        ASSERT_STREQ(actual, expected) << "len " << len;
+
+        if (len == 0) {
+            continue;
+        }
+        for (uint8_t decimals : {(uint8_t)COIN_AMOUNT_DECIMAL, (uint8_t)6}) {
+            ASSERT_EQ(printBigIntFixedPoint(number, len, expected, sizeof(expected), 0, &pageCount, decimals), parser_ok);
+            ASSERT_EQ(printEvmNumber(number, len, decimals, NULL, actual, sizeof(actual), 0, &pageCount), parser_ok);
+            ASSERT_STREQ(actual, expected) << "len " << len << " decimals " << (int)decimals;
+        }
+    }
+
+    // Wider than an RLP integer can be
+    uint8_t wide[EVM_NUMBER_MAX_LEN + 1] = {1};
+    EXPECT_EQ(evm_number_to_str(wide, sizeof(wide), 0, actual, sizeof(actual)), parser_value_out_of_range);
+    // 2^256 - 1 does not fit in a short buffer
+    memset(number, 0xFF, sizeof(number));
+    EXPECT_EQ(evm_number_to_str(number, sizeof(number), 0, actual, 78), parser_unexpected_buffer_end);
+    ASSERT_EQ(evm_number_to_str(number, sizeof(number), 0, actual, 79), parser_ok);
+    EXPECT_STREQ(actual, "115792089237316195423570985008687907853269984665640564039457584007913129639935");
+}
+
+TEST(NodeId, FixedWidthBase58MatchesGenericEncoder) {
+    std::mt19937_64 rng(0xcb58);
+    uint8_t payload[NODE_ID_PAYLOAD_LEN];
+    unsigned char expected[64];
+    char actual[NODE_ID_BASE58_MAX_LEN + 1];
+
+    for (int i = 0; i < 20000; i++) {
+        for (auto &b : payload) {
+            b = static_cast<uint8_t>(rng());
+        }
+        // Leading zero bytes turn into '1's, cover every count of them
+        const uint8_t zeros = (i < 200) ? (i % (NODE_ID_PAYLOAD_LEN + 1)) : 0;
+        memset(payload, 0, zeros);
+
+        size_t expectedLen = sizeof(expected);
+        memset(expected, 0, sizeof(expected));
+        ASSERT_EQ(encode_base58(payload, sizeof(payload), expected, &expectedLen), 0);
+        const uint8_t len = encode_base58_node_id(payload, actual);
+        ASSERT_STREQ(actual, reinterpret_cast<const char *>(expected)) << "zeros " << (int)zeros;
+        ASSERT_EQ(len, strlen(actual));
+        ASSERT_LE(len, NODE_ID_BASE58_MAX_LEN);
+    }
+
+    uint8_t nodeId[NODE_ID_LEN];
+    parseHexString(nodeId, sizeof(nodeId), "de31b4d8b22991d51aa6aa1fc733f23a851a8c94");
+    char nodeIdStr[NODE_ID_MAX_SIZE];
+    ASSERT_EQ(encodeNodeId(nodeId, nodeIdStr, sizeof(nodeIdStr)), parser_ok);
+    EXPECT_STREQ(nodeIdStr, "NodeID-MFrZFVCXPv5iCn6M9K6XduxGTYp891xXZ");
+    EXPECT_EQ(encodeNodeId(nodeId, nodeIdStr, sizeof(nodeIdStr) - 1), parser_unexpected_error);
+}
+
+static std::string legacy_timestamp(uint64_t timestamp) {
+    timedata_t date = {0};
+    if (extractTime(timestamp, &date) != zxerr_ok) {
+        return "";
+    }
+    char time_str[30] = {0};
+    snprintf(time_str, sizeof(time_str), "%04d-%02d-%02d %02d:%02d:%02d UTC", date.tm_year, date.tm_mon, date.tm_day,
+             date.tm_hour, date.tm_min, date.tm_sec);
+    return time_str;
+}
+
+TEST(Timestamp, MatchesExtractTimeFormatting) {
+    std::mt19937_64 rng(0x7153);
+    char out[TIMESTAMP_STR_LEN + 1];
+
+    // Every day until 2200, then every 97th day up to 9999-12-31, at its first, last and a random second
+    const uint64_t every_day_until = 7258118400ULL / 86400;
+    for (uint64_t day = 0; day <= TIMESTAMP_MAX / 86400; day += (day < every_day_until) ? 1 : 97) {
+        for (uint64_t second : {(uint64_t)0, (uint64_t)86399, (uint64_t)(rng() % 86400)}) {
+            const uint64_t timestamp = day * 86400 + second;
+            ASSERT_EQ(formatTimestamp(timestamp, out, sizeof(out)), parser_ok) << timestamp;
+            ASSERT_EQ(std::string(out), legacy_timestamp(timestamp)) << timestamp;
+        }
+    }
+
+    // Boundary years
+    const std::pair<uint64_t, const char *> cases[] = {
+        {0, "1970-01-01 00:00:00 UTC"},
+        {951782400, "2000-02-29 00:00:00 UTC"},
+        {4107542399, "2100-02-28 23:59:59 UTC"},
+        {4107542400, "2100-03-01 00:00:00 UTC"},
+        {13574563200, "2400-02-29 00:00:00 UTC"},
+        {13601001600, "2400-12-31 00:00:00 UTC"},
+        {240784617600, "9600-02-29 00:00:00 UTC"},
+        {250251724800, "9900-03-01 00:00:00 UTC"},
+        {TIMESTAMP_MAX, "9999-12-31 23:59:59 UTC"},
+    };
+    for (const auto &c : cases) {
+        ASSERT_EQ(formatTimestamp(c.first, out, sizeof(out)), parser_ok);
+        EXPECT_STREQ(out, c.second);
+        EXPECT_EQ(legacy_timestamp(c.first), c.second);
+    }
+
+    EXPECT_EQ(formatTimestamp(TIMESTAMP_MAX + 1, out, sizeof(out)), parser_invalid_time_stamp);
+    EXPECT_EQ(formatTimestamp(UINT64_MAX, out, sizeof(out)), parser_invalid_time_stamp);
+    EXPECT_EQ(formatTimestamp(0, out, TIMESTAMP_STR_LEN), parser_unexpected_buffer_end);
+}
+
+TEST(Writer, TruncatesLikeSnprintf) {
+    char out[8];
+    writer_t w;
+
+    writer_init(&w, out, sizeof(out));
+    writer_append_str(&w, "P to ");
+    writer_append_char(&w, 'C');
+    EXPECT_STREQ(out, "P to C");
+    EXPECT_FALSE(w.overflow);
+    writer_append_str(&w, " chain");
+    EXPECT_STREQ(out, "P to C ");
+    EXPECT_TRUE(w.overflow);
+
+    writer_init(&w, out, sizeof(out));
+    writer_append_u64(&w, 18446744073709551615ULL);
+    EXPECT_STREQ(out, "1844674");
+
+    const uint8_t data[] = {0xa9, 0x05, 0x9c, 0xbb};
+    writer_init(&w, out, sizeof(out));
+    writer_append_hex(&w, data, sizeof(data));
+    EXPECT_STREQ(out, "a9059cb");
+
+    // Zero-sized buffers are left alone
+    writer_init(&w, out, 0);
+    writer_append_str(&w, "x");
+    EXPECT_TRUE(w.overflow);
+
+    write_str(out, sizeof(out), "Fee");
+    EXPECT_STREQ(out, "Fee");
+    write_str(out, 1, "Fee");
+    EXPECT_STREQ(out, "");
+}
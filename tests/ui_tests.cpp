@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "app_mode.h"
+#include "crypto_helper.h"
 #include "expected_output.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -36,6 +37,7 @@
 #include "parser_common.h"
 #include "parser_evm.h"
 #include "testcases.h"
+#include "tx.h"
 #include "utils/common.h"
 
 using ::testing::TestWithParam;
@@ -167,6 +169,136 @@ void check_testcase(const testcase_t &tc, bool expert_mode, bool is_eth) {
     }
 }
 
+// Feeds the blob to the resumable parser chunk_size bytes at a time and
+// checks the review matches the one of a single shot parse.
+void check_testcase_chunked(const testcase_t &tc, uint16_t chunk_size) {
+    app_mode_set_expert(false);
+
+    parser_error_t err;
+    parser_context_t ctx;
+
+    uint8_t buffer[5000];
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), tc.blob.c_str());
+
+    parser_tx_t tx_obj;
+    memset(&tx_obj, 0, sizeof(tx_obj));
+
+    for (uint16_t received = chunk_size; received < bufferLen; received += chunk_size) {
+        err = parser_parse_chunk(&ctx, buffer, received, &tx_obj, false);
+        ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err) << " after " << received << " bytes";
+    }
+    err = parser_parse_chunk(&ctx, buffer, bufferLen, &tx_obj, true);
+    ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err);
+
+    auto output = dumpUI(&ctx, 39, 39, false);
+
+    EXPECT_EQ(output.size(), tc.expected.size());
+    for (size_t i = 0; i < tc.expected.size(); i++) {
+        if (i < output.size()) {
+            EXPECT_THAT(output[i], testing::Eq(tc.expected[i]));
+        }
+    }
+}
+
+// The digest the tx layer keeps while the tx is appended chunk by chunk must
+// match the one computed over the whole buffer at signing time.
+void check_streamed_digest(const testcase_t &tc) {
+    uint8_t buffer[5000];
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), tc.blob.c_str());
+
+    uint8_t expected[32] = {0};
+    ASSERT_EQ(crypto_sha256(buffer, bufferLen, expected, sizeof(expected)), zxerr_ok);
+
+    tx_initialize();
+    tx_select_digest(crypto_digest_sha256);
+    for (uint16_t chunk_size : {1, 7, 250}) {
+        tx_reset();
+        for (uint16_t offset = 0; offset < bufferLen; offset += chunk_size) {
+            const uint16_t len = std::min<uint16_t>(chunk_size, bufferLen - offset);
+            ASSERT_EQ(tx_append(buffer + offset, len), len);
+        }
+
+        uint8_t sha256[32] = {0};
+        ASSERT_EQ(tx_get_sha256_digest(sha256, sizeof(sha256)), zxerr_ok);
+        EXPECT_EQ(memcmp(sha256, expected, sizeof(expected)), 0) << "chunk size " << chunk_size;
+        EXPECT_EQ(tx_get_keccak_digest(sha256, sizeof(sha256)), zxerr_no_data);
+    }
+}
+
+// parser_validate must accept a tx exactly when every item of its review
+// renders. Every byte of the blob is flipped in turn to reach the failure
+// paths (fees, chain aliases, timestamps, ...) of both.
+void check_validation_matches_rendering(const testcase_t &tc) {
+    app_mode_set_expert(false);
+
+    uint8_t blob[5000];
+    const uint16_t bufferLen = parseHexString(blob, sizeof(blob), tc.blob.c_str());
+
+    for (uint16_t pos = 0; pos <= bufferLen; pos++) {
+        for (uint8_t mask : {0x01, 0xFF}) {
+            uint8_t buffer[5000];
+            memcpy(buffer, blob, bufferLen);
+            if (pos < bufferLen) {
+                buffer[pos] ^= mask;
+            }
+
+            parser_context_t ctx;
+            parser_tx_t tx_obj;
+            memset(&tx_obj, 0, sizeof(tx_obj));
+            if (parser_parse(&ctx, buffer, bufferLen, &tx_obj) != parser_ok) {
+                continue;
+            }
+            const bool valid = parser_validate(&ctx) == parser_ok;
+
+            bool renders = true;
+            uint8_t numItems = 0;
+            if (parser_getNumItems(&ctx, &numItems) != parser_ok) {
+                renders = false;
+            }
+            for (uint8_t idx = 0; renders && idx < numItems; idx++) {
+                char outKey[40];
+                char outVal[40];
+                uint8_t pageCount = 0;
+                renders = parser_getItem(&ctx, idx, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount) ==
+                          parser_ok;
+            }
+
+            EXPECT_EQ(valid, renders) << "byte " << pos << " xor " << (int)mask;
+        }
+    }
+}
+
+// parser_getItemPageCount must agree with the page count parser_getItem reports,
+// whether it answers from the value type or has to render it.
+void check_page_count(const testcase_t &tc) {
+    uint8_t buffer[5000];
+    const uint16_t bufferLen = parseHexString(buffer, sizeof(buffer), tc.blob.c_str());
+
+    for (bool expert : {false, true}) {
+        app_mode_set_expert(expert);
+        parser_context_t ctx;
+        parser_tx_t tx_obj;
+        memset(&tx_obj, 0, sizeof(tx_obj));
+        ASSERT_EQ(parser_parse(&ctx, buffer, bufferLen, &tx_obj), parser_ok);
+
+        uint8_t numItems = 0;
+        ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+        for (uint16_t outValLen : {2, 5, 12, 17, 39, 64, 65, 100, 300}) {
+            for (uint8_t idx = 0; idx < numItems; idx++) {
+                char outKey[40];
+                char outVal[300];
+                uint8_t expected = 0;
+                ASSERT_EQ(parser_getItem(&ctx, idx, outKey, sizeof(outKey), outVal, outValLen, 0, &expected), parser_ok);
+
+                uint8_t pageCount = 0xFF;
+                ASSERT_EQ(parser_getItemPageCount(&ctx, idx, outValLen, &pageCount), parser_ok);
+                EXPECT_EQ(pageCount, expected) << outKey << " item " << (int)idx << " width " << outValLen;
+            }
+        }
+    }
+    app_mode_set_expert(false);
+}
+
 class VerifyEvmTransactions : public JsonTestsA {};
 
 INSTANTIATE_TEST_SUITE_P(JsonTestCasesCurrentTxVer, JsonTestsA,
@@ -178,4 +310,91 @@ INSTANTIATE_TEST_SUITE_P(EVMJsonTestCasesCurrentTxVer, VerifyEvmTransactions,
 
 TEST_P(JsonTestsA, JsonTestsA_CheckUIOutput_CurrentTX_Normal) { check_testcase(GetParam(), false, false); }
 TEST_P(JsonTestsA, JsonTestsA_CheckUIOutput_CurrentTX_Expert) { check_testcase(GetParam(), true, false); }
+TEST_P(JsonTestsA, JsonTestsA_CheckUIOutput_CurrentTX_Chunked) {
+    for (uint16_t chunk_size : {1, 7, 250}) {
+        check_testcase_chunked(GetParam(), chunk_size);
+    }
+}
+TEST_P(JsonTestsA, JsonTestsA_StreamedDigest) { check_streamed_digest(GetParam()); }
+TEST_P(JsonTestsA, JsonTestsA_ValidationMatchesRendering) { check_validation_matches_rendering(GetParam()); }
+TEST_P(JsonTestsA, JsonTestsA_PageCountMatchesRendering) { check_page_count(GetParam()); }
 TEST_P(VerifyEvmTransactions, JsonTestsEVM_CheckUIOutput_CurrentTX_Normal) { check_testcase(GetParam(), false, true); }
+TEST_P(VerifyEvmTransactions, JsonTestsEVM_StreamedDigest) { check_streamed_digest(GetParam()); }
+
+// Appends the blob to a fresh tx in chunks of chunk_size
+static void append_tx(uint8_t *blob, uint16_t blobLen, uint16_t chunk_size) {
+    for (uint16_t offset = 0; offset < blobLen; offset += chunk_size) {
+        tx_append(blob + offset, std::min<uint16_t>(chunk_size, blobLen - offset));
+    }
+}
+
+TEST(TxDigest, SelectingAnotherKindMidTxInvalidatesIt) {
+    uint8_t blob[64];
+    for (uint8_t i = 0; i < sizeof(blob); i++) {
+        blob[i] = i;
+    }
+    uint8_t expected[32] = {0};
+    ASSERT_EQ(crypto_sha256(blob, sizeof(blob), expected, sizeof(expected)), zxerr_ok);
+    uint8_t digest[32] = {0};
+
+    tx_initialize();
+    tx_select_digest(crypto_digest_sha256);
+    tx_reset();
+    append_tx(blob, 32, 8);
+
+    // The chunks already appended were hashed with SHA-256, nothing else can cover them
+    tx_select_digest(crypto_digest_keccak256);
+    EXPECT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_no_data);
+    EXPECT_EQ(tx_get_keccak_digest(digest, sizeof(digest)), zxerr_unknown);
+
+    // Going back does not revive the SHA-256 stream either
+    tx_select_digest(crypto_digest_sha256);
+    append_tx(blob + 32, 32, 8);
+    EXPECT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_unknown);
+
+    // The next tx streams the selected kind again
+    tx_reset();
+    append_tx(blob, sizeof(blob), 8);
+    ASSERT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_ok);
+    EXPECT_EQ(memcmp(digest, expected, sizeof(expected)), 0);
+
+    // Selecting the kind in use keeps the digest
+    tx_select_digest(crypto_digest_sha256);
+    ASSERT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_ok);
+    EXPECT_EQ(memcmp(digest, expected, sizeof(expected)), 0);
+}
+
+TEST(TxDigest, DataAppendedAfterTheDigestIsNotCovered) {
+    uint8_t blob[64] = {0};
+    uint8_t digest[32] = {0};
+
+    tx_initialize();
+    tx_select_digest(crypto_digest_sha256);
+    tx_reset();
+    append_tx(blob, 32, 32);
+    ASSERT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_ok);
+
+    append_tx(blob + 32, 32, 32);
+    EXPECT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_unknown);
+    EXPECT_EQ(tx_get_sha256_digest(digest, 31), zxerr_buffer_too_small);
+}
+
+TEST(TxDigest, InstructionsWithoutDigestHashNothing) {
+    uint8_t blob[64] = {0};
+    uint8_t digest[32] = {0};
+
+    tx_initialize();
+    tx_select_digest(crypto_digest_none);
+    tx_reset();
+    append_tx(blob, sizeof(blob), 16);
+    EXPECT_EQ(tx_get_sha256_digest(digest, sizeof(digest)), zxerr_no_data);
+    EXPECT_EQ(tx_get_keccak_digest(digest, sizeof(digest)), zxerr_no_data);
+
+    // Keccak-256 is only available on device
+    tx_select_digest(crypto_digest_keccak256);
+    tx_reset();
+    append_tx(blob, sizeof(blob), 16);
+    EXPECT_EQ(tx_get_keccak_digest(digest, sizeof(digest)), zxerr_unknown);
+
+    tx_select_digest(crypto_digest_sha256);
+}
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "bip32_shim.h"
+
+#include <cstring>
+
+#include "bip32_cache.h"
+
+bip32_shim_ops bip32_shim_counts;
+uint32_t bip32_shim_fail_hmac = UINT32_MAX;
+
+void bip32_shim_reset() { memset(&bip32_shim_counts, 0, sizeof(bip32_shim_counts)); }
+
+namespace {
+
+// Deterministic 64-byte mix of key and data, standing in for HMAC-SHA512
+void mix(const uint8_t *key, size_t keyLen, const uint8_t *data, size_t dataLen, uint8_t *out) {
+    for (uint8_t word = 0; word < 8; word++) {
+        uint64_t h = 0xcbf29ce484222325ULL ^ word;
+        for (size_t i = 0; i < keyLen; i++) {
+            h = (h ^ key[i]) * 0x100000001b3ULL;
+        }
+        for (size_t i = 0; i < dataLen; i++) {
+            h = (h ^ data[i]) * 0x100000001b3ULL;
+        }
+        for (uint8_t b = 0; b < 8; b++) {
+            out[8 * word + b] = static_cast<uint8_t>(h >> (56 - 8 * b));
+        }
+    }
+}
+
+void put_index(uint8_t *out, uint32_t index) {
+    out[0] = static_cast<uint8_t>(index >> 24);
+    out[1] = static_cast<uint8_t>(index >> 16);
+    out[2] = static_cast<uint8_t>(index >> 8);
+    out[3] = static_cast<uint8_t>(index);
+}
+
+}  // namespace
+
+extern "C" {
+
+zxerr_t bip32_hmac_sha512(const uint8_t *key, const uint8_t *data, uint16_t dataLen, uint8_t *mac) {
+    if (bip32_shim_counts.hmac++ == bip32_shim_fail_hmac) {
+        return zxerr_unknown;
+    }
+    mix(key, BIP32_CHAIN_CODE_LEN, data, dataLen, mac);
+    return zxerr_ok;
+}
+
+zxerr_t bip32_public_key(const uint8_t *private_key, uint8_t *public_key) {
+    bip32_shim_counts.point_mul++;
+    uint8_t point[64];
+    mix(private_key, BIP32_KEY_LEN, nullptr, 0, point);
+    public_key[0] = 0x02 | (point[63] & 1);
+    memcpy(public_key + 1, point, BIP32_PUBKEY_LEN - 1);
+    return zxerr_ok;
+}
+
+// Addition modulo 2^256 keeps the shape of the device's addition modulo n
+zxerr_t bip32_scalar_add(const uint8_t *tweak, uint8_t *private_key) {
+    bip32_shim_counts.scalar_add++;
+    uint16_t carry = 0;
+    uint8_t any = 0;
+    for (int i = BIP32_KEY_LEN - 1; i >= 0; i--) {
+        carry = static_cast<uint16_t>(carry + tweak[i] + private_key[i]);
+        private_key[i] = static_cast<uint8_t>(carry);
+        carry >>= 8;
+        any |= private_key[i];
+    }
+    return any ? zxerr_ok : zxerr_unknown;
+}
+
+// What os_derive_bip32_with_seed_no_throw does: the master node from the seed, then CKDpriv
+// per level, computing the parent public key at non-hardened levels
+zxerr_t bip32_derive_node(const uint32_t *path, uint32_t path_len, uint8_t *private_key, uint8_t *chain_code) {
+    bip32_shim_counts.seed_derivations++;
+    static const uint8_t seed_key[] = "Bitcoin seed";
+    uint8_t seed[64];
+    memset(seed, 0x5e, sizeof(seed));
+
+    uint8_t mac[64];
+    bip32_shim_counts.hmac++;
+    mix(seed_key, sizeof(seed_key) - 1, seed, sizeof(seed), mac);
+    uint8_t key[BIP32_KEY_LEN];
+    uint8_t chain[BIP32_CHAIN_CODE_LEN];
+    memcpy(key, mac, sizeof(key));
+    memcpy(chain, mac + BIP32_KEY_LEN, sizeof(chain));
+
+    for (uint32_t level = 0; level < path_len; level++) {
+        uint8_t data[BIP32_PUBKEY_LEN + 4];
+        if (path[level] & BIP32_HARDENED) {
+            data[0] = 0;
+            memcpy(data + 1, key, BIP32_KEY_LEN);
+        } else {
+            CHECK_ZXERR(bip32_public_key(key, data))
+        }
+        put_index(data + BIP32_PUBKEY_LEN, path[level]);
+        CHECK_ZXERR(bip32_hmac_sha512(chain, data, sizeof(data), mac))
+        CHECK_ZXERR(bip32_scalar_add(mac, key))
+        memcpy(chain, mac + BIP32_KEY_LEN, sizeof(chain));
+    }
+
+    memcpy(private_key, key, sizeof(key));
+    if (chain_code != nullptr) {
+        memcpy(chain_code, chain, sizeof(chain));
+    }
+    return zxerr_ok;
+}
+}
@@ -0,0 +1,35 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include <cstdint>
+
+// Host stand-in for the device primitives of bip32_cache.c. Its arithmetic is not secp256k1:
+// it keeps the BIP32 structure, so keys reached through the cache can be checked against keys
+// derived from the seed, and counts the operations each derivation costs on device.
+struct bip32_shim_ops {
+    uint32_t seed_derivations;
+    uint32_t hmac;
+    uint32_t point_mul;
+    uint32_t scalar_add;
+};
+
+extern bip32_shim_ops bip32_shim_counts;
+
+// HMAC call, counted from the next reset, that fails; UINT32_MAX for none
+extern uint32_t bip32_shim_fail_hmac;
+
+void bip32_shim_reset();
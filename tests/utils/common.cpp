@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 
+#include "gtest/gtest.h"
 #include "parser_common.h"
 #include "parser_evm.h"
 
@@ -45,13 +46,24 @@ std::vector<std::string> dumpUI(parser_context_t *ctx, uint16_t maxKeyLen, uint1
         uint8_t pageIdx = 0;
         uint8_t pageCount = 1;
 
+        // Lay out the pages first; each page is then rendered once
+        if (!is_eth && (parser_getItemPageCount(ctx, idx, maxValueLen, &pageCount) != parser_ok || pageCount == 0)) {
+            pageCount = 1;
+        }
+
         while (pageIdx < pageCount) {
             std::stringstream ss;
 
             if (is_eth) {
                 err = parser_getItemEth(ctx, idx, keyBuffer, maxKeyLen, valueBuffer, maxValueLen, pageIdx, &pageCount);
             } else {
-                err = parser_getItem(ctx, idx, keyBuffer, maxKeyLen, valueBuffer, maxValueLen, pageIdx, &pageCount);
+                uint8_t renderedPageCount = 0;
+                err = parser_getItem(ctx, idx, keyBuffer, maxKeyLen, valueBuffer, maxValueLen, pageIdx,
+                                     &renderedPageCount);
+                // The golden vectors check the page count rendering reports
+                if (err == parser_ok) {
+                    EXPECT_EQ(renderedPageCount, pageCount) << "item " << idx << " page " << (int)pageIdx;
+                }
             }
             ss << idx << " | " << keyBuffer;
             if (pageCount > 1) {
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "tx_builder.h"
+
+#include <hexutils.h>
+
+#include <cstdio>
+
+#include "parser_txdef.h"
+
+const char kBaseTxPrefix[] =
+    "0000"
+    "00000022"
+    "0000000e"
+    "0000000000000000000000000000000000000000000000000000000000000000";
+
+namespace {
+
+std::string u32_hex(uint32_t value) {
+    char hex[9];
+    snprintf(hex, sizeof(hex), "%08x", value);
+    return hex;
+}
+
+std::string u64_hex(uint64_t value) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)value);
+    return hex;
+}
+
+}  // namespace
+
+std::string address_hex(uint8_t byte) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    std::string address;
+    for (uint8_t i = 0; i < ADDRESS_LEN; i++) {
+        address += hex;
+    }
+    return address;
+}
+
+std::string base_tx_hex(const std::vector<base_tx_output_t> &outputs, uint64_t input_amount) {
+    const std::string asset_id(2 * ASSET_ID_LEN, '1');
+
+    std::string hex = std::string(kBaseTxPrefix) + u32_hex(static_cast<uint32_t>(outputs.size()));
+    for (const auto &output : outputs) {
+        // SECP transfer output without locktime, spendable by any single owner
+        hex += asset_id + u32_hex(SECP_TYPE_ID) + u64_hex(output.amount) + u64_hex(0) + u32_hex(1) +
+               u32_hex(static_cast<uint32_t>(output.owners.size() / (2 * ADDRESS_LEN))) + output.owners;
+    }
+
+    // One input, signed by its first owner
+    hex += u32_hex(1) + std::string(2 * TX_ID_LEN, '3') + u32_hex(0) + asset_id + u32_hex(SECP_INPUT_TYPE_ID) +
+           u64_hex(input_amount) + u32_hex(1) + u32_hex(0);
+
+    // Empty memo
+    return hex + u32_hex(0);
+}
+
+std::vector<uint8_t> base_tx_bytes(const std::vector<base_tx_output_t> &outputs, uint64_t input_amount) {
+    const std::string hex = base_tx_hex(outputs, input_amount);
+    std::vector<uint8_t> blob(hex.size() / 2);
+    blob.resize(parseHexString(blob.data(), static_cast<uint16_t>(blob.size()), hex.c_str()));
+    return blob;
+}
@@ -0,0 +1,36 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// First bytes of a mainnet P-chain BaseTx, up to the number of outputs
+extern const char kBaseTxPrefix[];
+
+struct base_tx_output_t {
+    uint64_t amount;
+    // Owner addresses, ADDRESS_LEN bytes each, as hex
+    std::string owners;
+};
+
+// Owner address made of a single repeated byte, as hex
+std::string address_hex(uint8_t byte);
+
+// Mainnet P-chain BaseTx paying outputs out of a single input of input_amount, with an empty memo
+std::string base_tx_hex(const std::vector<base_tx_output_t> &outputs, uint64_t input_amount);
+std::vector<uint8_t> base_tx_bytes(const std::vector<base_tx_output_t> &outputs, uint64_t input_amount);